@@ -690,6 +690,11 @@ void run_datagen(const DatagenConfig& config) {
                         limits.seed = rng.next_u64();
                         limits.use_tt_new_search = false;
                         limits.use_global_context = false;
+                        if (config.use_multipv) {
+                            // Softmax samples top_n and epsilon-greedy top_k;
+                            // both must be exact rather than null-window bounds
+                            limits.multi_pv = std::max(config.sample_top_k, config.sample_top_n);
+                        }
 
                         // Rust: FixedNodes(50_000)
                         if (config.search_nodes > 0) {
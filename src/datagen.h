@@ -19,6 +19,7 @@ struct DatagenConfig {
     int search_depth = 0; // Default to 0 so nodes limit takes precedence
     int sample_top_n = 4;
     int sample_top_k = 4;
+    bool use_multipv = false; // Exact root scores for the sampled moves
     int temp_schedule_plies = 40;
     double temp_start = 1.0;
     double temp_end = 0.6;
@@ -0,0 +1,247 @@
+#include "endgame.h"
+#include "eval_params.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace Endgames {
+
+namespace {
+
+    constexpr Bitboard LIGHT_SQUARES = 0x55AA55AA55AA55AAULL;
+
+    int distance(Square a, Square b) {
+        return std::max(std::abs(file_of(a) - file_of(b)), std::abs(rank_of(a) - rank_of(b)));
+    }
+
+    // Bonus for the losing king near the edge / the kings close together
+    int push_to_edge(Square s) {
+        int fd = std::min<int>(file_of(s), FILE_H - file_of(s));
+        int rd = std::min<int>(rank_of(s), RANK_8 - rank_of(s));
+        return 90 - (7 * fd * fd / 2 + 7 * rd * rd / 2);
+    }
+
+    int push_close(Square a, Square b) {
+        return 140 - 20 * distance(a, b);
+    }
+
+    // Toward a1/h8, the corners a dark-squared bishop covers
+    int push_to_dark_corner(Square s) {
+        return std::abs(7 - rank_of(s) - file_of(s)) * 20;
+    }
+
+    Square king_square(const Position& pos, Color c) {
+        return Bitboards::lsb(pos.pieces(KING, c));
+    }
+
+    // Rank-flipped for Black, so the strong side always plays up the board
+    Square relative(Color c, Square s) {
+        return c == WHITE ? s : (Square)(s ^ 56);
+    }
+
+    // ------------------------------------------------------------------------
+    // KPK bitbase: white king, white pawn on files A-D (mirrored), black king,
+    // side to move; solved by iterating from mates/draws until nothing changes
+    // ------------------------------------------------------------------------
+
+    constexpr int KPK_SIZE = 2 * 24 * 64 * 64;
+
+    int kpk_index(Color stm, Square bk, Square wk, Square pawn) {
+        return wk | (bk << 6) | (stm << 12) | (file_of(pawn) << 13) | ((RANK_7 - rank_of(pawn)) << 15);
+    }
+
+    enum KPKResult : uint8_t { INVALID = 0, UNKNOWN = 1, DRAW = 2, WIN = 4 };
+
+    KPKResult kpk_initial(Color stm, Square wk, Square bk, Square pawn) {
+        if (distance(wk, bk) <= 1 || wk == pawn || bk == pawn
+            || (stm == WHITE && Bitboards::check_bit(Bitboards::get_pawn_attacks(pawn, WHITE), bk))) {
+            return INVALID;
+        }
+        // Promotes, and the new queen cannot be taken
+        Square push = pawn + NORTH;
+        if (stm == WHITE && rank_of(pawn) == RANK_7 && wk != push
+            && (distance(bk, push) > 1 || distance(wk, push) == 1)) {
+            return WIN;
+        }
+        // Stalemate, or the pawn falls
+        Bitboard bk_moves = Bitboards::get_king_attacks(bk);
+        Bitboard wk_guard = Bitboards::get_king_attacks(wk);
+        if (stm == BLACK
+            && (!(bk_moves & ~(wk_guard | Bitboards::get_pawn_attacks(pawn, WHITE)))
+                || Bitboards::check_bit(bk_moves & ~wk_guard, pawn))) {
+            return DRAW;
+        }
+        return UNKNOWN;
+    }
+
+    // White needs one winning move; Black needs one drawing move
+    KPKResult kpk_classify(const std::vector<uint8_t>& db, Color stm, Square wk, Square bk, Square pawn) {
+        KPKResult good = (stm == WHITE) ? WIN : DRAW;
+        KPKResult bad = (stm == WHITE) ? DRAW : WIN;
+
+        int r = INVALID;
+        Bitboard b = Bitboards::get_king_attacks(stm == WHITE ? wk : bk);
+        while (b) {
+            Square to = Bitboards::pop_lsb(b);
+            r |= (stm == WHITE) ? db[kpk_index(BLACK, bk, to, pawn)] : db[kpk_index(WHITE, to, wk, pawn)];
+        }
+        if (stm == WHITE) {
+            if (rank_of(pawn) < RANK_7) r |= db[kpk_index(BLACK, bk, wk, pawn + NORTH)];
+            if (rank_of(pawn) == RANK_2 && pawn + NORTH != wk && pawn + NORTH != bk) {
+                r |= db[kpk_index(BLACK, bk, wk, pawn + NORTH + NORTH)];
+            }
+        }
+        return (r & good) ? good : (r & UNKNOWN) ? UNKNOWN : bad;
+    }
+
+    class KPKBitbase {
+    public:
+        KPKBitbase() {
+            auto decode = [](int idx, Color& stm, Square& wk, Square& bk, Square& pawn) {
+                wk = (Square)(idx & 63);
+                bk = (Square)((idx >> 6) & 63);
+                stm = (Color)((idx >> 12) & 1);
+                pawn = square_of((File)((idx >> 13) & 3), (Rank)(RANK_7 - (idx >> 15)));
+            };
+
+            std::vector<uint8_t> db(KPK_SIZE);
+            Color stm;
+            Square wk, bk, pawn;
+            for (int idx = 0; idx < KPK_SIZE; idx++) {
+                decode(idx, stm, wk, bk, pawn);
+                db[idx] = kpk_initial(stm, wk, bk, pawn);
+            }
+            for (bool changed = true; changed; ) {
+                changed = false;
+                for (int idx = 0; idx < KPK_SIZE; idx++) {
+                    if (db[idx] != UNKNOWN) continue;
+                    decode(idx, stm, wk, bk, pawn);
+                    db[idx] = kpk_classify(db, stm, wk, bk, pawn);
+                    changed |= db[idx] != UNKNOWN;
+                }
+            }
+            for (int idx = 0; idx < KPK_SIZE; idx++) {
+                if (db[idx] == WIN) bits[idx >> 6] |= 1ULL << (idx & 63);
+            }
+        }
+
+        bool win(int idx) const { return (bits[idx >> 6] >> (idx & 63)) & 1; }
+
+    private:
+        uint64_t bits[KPK_SIZE / 64] = {};
+    };
+
+    // ------------------------------------------------------------------------
+    // Evaluators, from the strong side's point of view
+    // ------------------------------------------------------------------------
+
+    int evaluate_draw(const Position&, Color) {
+        return 0;
+    }
+
+    // Mating material against a bare king: drive it to the edge
+    int evaluate_kxk(const Position& pos, Color strong) {
+        Square sk = king_square(pos, strong);
+        Square wk = king_square(pos, ~strong);
+
+        int v = push_to_edge(wk) + push_close(sk, wk);
+        for (int pt = PAWN; pt < KING; pt++) {
+            v += Bitboards::count(pos.pieces((PieceType)pt, strong)) * Eval::Params.EG_VALS[pt];
+        }
+
+        Bitboard bishops = pos.pieces(BISHOP, strong);
+        bool mating = pos.pieces(QUEEN, strong) || pos.pieces(ROOK, strong)
+            || (bishops && pos.pieces(KNIGHT, strong))
+            || ((bishops & LIGHT_SQUARES) && (bishops & ~LIGHT_SQUARES));
+        return mating ? KNOWN_WIN + std::min(v, KNOWN_WIN / 2) : v;
+    }
+
+    // Mate only happens in a corner of the bishop's colour
+    int evaluate_kbnk(const Position& pos, Color strong) {
+        Square sk = king_square(pos, strong);
+        Square wk = king_square(pos, ~strong);
+        bool light = pos.pieces(BISHOP, strong) & LIGHT_SQUARES;
+        return KNOWN_WIN + push_close(sk, wk) + push_to_dark_corner(light ? (Square)(wk ^ 7) : wk);
+    }
+
+    int evaluate_kpk(const Position& pos, Color strong) {
+        Square pawn = Bitboards::lsb(pos.pieces(PAWN, strong));
+        if (!probe_kpk(strong, king_square(pos, strong), pawn, king_square(pos, ~strong), pos.side_to_move())) {
+            return 0;
+        }
+        return KNOWN_WIN + Eval::Params.EG_VALS[PAWN] + rank_of(relative(strong, pawn));
+    }
+
+    // Rook against pawn: a win unless the defending king escorts the pawn
+    int evaluate_krkp(const Position& pos, Color strong) {
+        Color weak = ~strong;
+        Square sk = relative(strong, king_square(pos, strong));
+        Square wk = relative(strong, king_square(pos, weak));
+        Square rook = relative(strong, Bitboards::lsb(pos.pieces(ROOK, strong)));
+        Square pawn = relative(strong, Bitboards::lsb(pos.pieces(PAWN, weak)));
+        Square queening = square_of(file_of(pawn), RANK_1);
+        int rook_value = Eval::Params.EG_VALS[ROOK];
+
+        // The strong king stands in front of the pawn
+        if (file_of(sk) == file_of(pawn) && rank_of(sk) < rank_of(pawn)) {
+            return rook_value - distance(sk, pawn);
+        }
+        // The defending king is too far from both pawn and rook
+        if (distance(wk, pawn) >= 3 + (pos.side_to_move() == weak) && distance(wk, rook) >= 3) {
+            return rook_value - distance(sk, pawn);
+        }
+        // Far advanced pawn next to its king: drawish
+        if (rank_of(wk) <= RANK_3 && distance(wk, pawn) == 1 && rank_of(sk) >= RANK_4
+            && distance(sk, pawn) > 2 + (pos.side_to_move() == strong)) {
+            return 80 - 8 * distance(sk, pawn);
+        }
+        Square below = pawn + SOUTH;
+        return 200 - 8 * (distance(sk, below) - distance(wk, below) - distance(pawn, queening));
+    }
+
+}
+
+bool probe_kpk(Color strong, Square strong_king, Square pawn, Square weak_king, Color stm) {
+    static const KPKBitbase bitbase;
+
+    Square wk = relative(strong, strong_king);
+    Square bk = relative(strong, weak_king);
+    Square p = relative(strong, pawn);
+    if (file_of(p) >= FILE_E) {
+        wk = (Square)(wk ^ 7);
+        bk = (Square)(bk ^ 7);
+        p = (Square)(p ^ 7);
+    }
+    return bitbase.win(kpk_index(stm == strong ? WHITE : BLACK, bk, wk, p));
+}
+
+EvalFn lookup(const Position& pos, Color& strong) {
+    for (Color c : {WHITE, BLACK}) {
+        Color weak = ~c;
+        strong = c;
+        int pawns = Bitboards::count(pos.pieces(PAWN, c));
+        int knights = Bitboards::count(pos.pieces(KNIGHT, c));
+        int bishops = Bitboards::count(pos.pieces(BISHOP, c));
+        int rooks = Bitboards::count(pos.pieces(ROOK, c));
+        int queens = Bitboards::count(pos.pieces(QUEEN, c));
+
+        if (pos.pieces(weak) == pos.pieces(KING, weak)) {
+            if (!pawns && !rooks && !queens) {
+                if (knights == 1 && bishops == 1) return evaluate_kbnk;
+                // KK, KNK, KBK, KNNK
+                if (bishops == 0 ? knights <= 2 : (bishops == 1 && knights == 0)) return evaluate_draw;
+            }
+            if (pawns == 1 && !knights && !bishops && !rooks && !queens) return evaluate_kpk;
+            if (queens || rooks || (bishops && knights) || bishops >= 2) return evaluate_kxk;
+        }
+
+        if (pos.pieces(c) == (pos.pieces(KING, c) | pos.pieces(ROOK, c)) && rooks == 1
+            && pos.pieces(weak) == (pos.pieces(KING, weak) | pos.pieces(PAWN, weak))
+            && Bitboards::count(pos.pieces(PAWN, weak)) == 1) {
+            return evaluate_krkp;
+        }
+    }
+    return nullptr;
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "../position.h"
+
+namespace Endgames {
+
+    // Known wins score above anything the regular eval returns and below
+    // tablebase wins (20000)
+    constexpr int KNOWN_WIN = 10000;
+
+    // Score of pos from the strong side's point of view
+    using EvalFn = int (*)(const Position& pos, Color strong);
+
+    // Specialized evaluator for pos's material, or nullptr. Only piece counts
+    // are looked at, so the answer can be cached by material key.
+    EvalFn lookup(const Position& pos, Color& strong);
+
+    // KPK bitbase (built on first use): does the side with the pawn win?
+    bool probe_kpk(Color strong, Square strong_king, Square pawn, Square weak_king, Color stm);
+
+}
+
+#endif // ENDGAME_H
@@ -1,10 +1,12 @@
 #include "eval.h"
 #include "eval_params.h"
 #include "../nnue/network.h"
+#include "../memory.h"
 #include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <new>
 
 namespace Eval {
 
@@ -37,8 +39,67 @@ namespace Eval {
     // Global Contempt Setting
     int GlobalContempt = 0;
 
-    // Pawn Hash Table
-    PawnEntry PawnHash[16384];
+    // Pawn and material tables: the calling thread's, see HashTable
+    static_assert(sizeof(PawnEntry) == 64, "PawnEntry should fill one cache line");
+    static_assert(sizeof(MaterialEntry) == 32, "MaterialEntry should fill half a cache line");
+    constexpr Key PAWN_KEY_SALT = 0x5D588B656C078965ULL; // Pawnless positions have key 0
+    thread_local PawnTable* CurrentPawnTable = nullptr;
+    thread_local MaterialTable* CurrentMaterialTable = nullptr;
+
+    PawnTable& pawn_table() {
+        if (!CurrentPawnTable) {
+            thread_local PawnTable fallback;
+            fallback.resize(1);
+            CurrentPawnTable = &fallback;
+        }
+        CurrentPawnTable->sync_params();
+        return *CurrentPawnTable;
+    }
+
+    MaterialTable& material_table() {
+        if (!CurrentMaterialTable) {
+            thread_local MaterialTable fallback;
+            fallback.resize(1);
+            CurrentMaterialTable = &fallback;
+        }
+        CurrentMaterialTable->sync_params();
+        return *CurrentMaterialTable;
+    }
+
+    template <typename Entry>
+    HashTable<Entry>::~HashTable() {
+        Memory::free_large(entries);
+    }
+
+    template <typename Entry>
+    void HashTable<Entry>::resize(size_t size_mb) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Entry) <= std::max<size_t>(size_mb, 1) * 1024 * 1024) count *= 2;
+        Memory::free_large(entries);
+        // Private to one thread and small: regular or transparent huge pages
+        entries = static_cast<Entry*>(Memory::alloc_large(count * sizeof(Entry), false));
+        if (!entries) {
+            mask = 0;
+            throw std::bad_alloc();
+        }
+        mask = count - 1;
+        clear();
+    }
+
+    template <typename Entry>
+    void HashTable<Entry>::clear() {
+        if (entries) std::memset(static_cast<void*>(entries), 0, (mask + 1) * sizeof(Entry));
+        hits = misses = 0;
+        params_version = ParamsVersion;
+    }
+
+    template class HashTable<PawnEntry>;
+    template class HashTable<MaterialEntry>;
+
+    void set_tables(PawnTable* pawns, MaterialTable* material) {
+        CurrentPawnTable = pawns;
+        CurrentMaterialTable = material;
+    }
 
     // ----------------------------------------------------------------------------
     // Helper Functions
@@ -82,16 +143,28 @@ namespace Eval {
     // Pawn Evaluation
     // ----------------------------------------------------------------------------
 
+    void prefetch_pawns(Key pawn_key) {
+        if (GlobalUseNNUE && NNUE::g_network) return;
+        __builtin_prefetch(&pawn_table().slot(pawn_key));
+    }
+
     PawnEntry evaluate_pawns(const Position& pos) {
         Key key = pos.pawn_key();
-        int idx = key & 16383;
-
-        if (PawnHash[idx].key == key) {
-            return PawnHash[idx];
+        PawnTable& table = pawn_table();
+        PawnEntry& slot = table.slot(key);
+
+        if (slot.key == (key ^ PAWN_KEY_SALT)) {
+#ifdef STATS
+            table.hits++;
+#endif
+            return slot;
         }
+#ifdef STATS
+        table.misses++;
+#endif
 
         PawnEntry entry;
-        entry.key = key;
+        entry.key = key ^ PAWN_KEY_SALT;
         entry.score_mg = 0;
         entry.score_eg = 0;
         entry.passed_pawns[WHITE] = 0;
@@ -270,7 +343,7 @@ namespace Eval {
             entry.score_eg += king_diff * Params.PAWN_MAJORITY_BONUS_EG;
         }
 
-        PawnHash[idx] = entry;
+        slot = entry;
         return entry;
     }
 
@@ -278,21 +351,23 @@ namespace Eval {
     // Scaling
     // ----------------------------------------------------------------------------
 
-    int get_scale_factor(const Position& pos, int phase_clamped) {
+    // Material part of the scale factor; only applies from the middle of the
+    // endgame (phase 12) down
+    int material_scale(const int (&n)[COLOR_NB][PIECE_TYPE_NB], int phase_clamped) {
         int scale = 128;
 
         if (phase_clamped > 12) {
             return scale;
         }
 
-        int white_pawns = Bitboards::count(pos.pieces(PAWN, WHITE));
-        int black_pawns = Bitboards::count(pos.pieces(PAWN, BLACK));
-        int white_rooks = Bitboards::count(pos.pieces(ROOK, WHITE));
-        int black_rooks = Bitboards::count(pos.pieces(ROOK, BLACK));
-        int white_queens = Bitboards::count(pos.pieces(QUEEN, WHITE));
-        int black_queens = Bitboards::count(pos.pieces(QUEEN, BLACK));
-        int white_minors = Bitboards::count(pos.pieces(KNIGHT, WHITE)) + Bitboards::count(pos.pieces(BISHOP, WHITE));
-        int black_minors = Bitboards::count(pos.pieces(KNIGHT, BLACK)) + Bitboards::count(pos.pieces(BISHOP, BLACK));
+        int white_pawns = n[WHITE][PAWN];
+        int black_pawns = n[BLACK][PAWN];
+        int white_rooks = n[WHITE][ROOK];
+        int black_rooks = n[BLACK][ROOK];
+        int white_queens = n[WHITE][QUEEN];
+        int black_queens = n[BLACK][QUEEN];
+        int white_minors = n[WHITE][KNIGHT] + n[WHITE][BISHOP];
+        int black_minors = n[BLACK][KNIGHT] + n[BLACK][BISHOP];
 
         // Pawnless drawish material
         if (white_pawns == 0 && black_pawns == 0 && white_queens == 0 && black_queens == 0) {
@@ -310,47 +385,98 @@ namespace Eval {
             }
         }
 
-        // Simple fortress heuristic: locked pawn chains, no open files, no major pieces.
-        if (white_queens == 0 && black_queens == 0 && white_rooks == 0 && black_rooks == 0) {
-            Bitboard white_pawn_bb = pos.pieces(PAWN, WHITE);
-            Bitboard black_pawn_bb = pos.pieces(PAWN, BLACK);
-            if (white_pawn_bb && black_pawn_bb) {
-                Bitboard white_attacks = 0;
-                Bitboard black_attacks = 0;
-                Bitboard wp = white_pawn_bb;
-                Bitboard bp = black_pawn_bb;
-                while (wp) {
-                    Square sq = (Square)Bitboards::pop_lsb(wp);
-                    white_attacks |= Bitboards::get_pawn_attacks(sq, WHITE);
-                }
-                while (bp) {
-                    Square sq = (Square)Bitboards::pop_lsb(bp);
-                    black_attacks |= Bitboards::get_pawn_attacks(sq, BLACK);
-                }
+        return scale;
+    }
 
-                Bitboard white_front = white_pawn_bb << 8;
-                Bitboard black_front = black_pawn_bb >> 8;
-                bool white_blocked = (white_front & ~black_pawn_bb) == 0;
-                bool black_blocked = (black_front & ~white_pawn_bb) == 0;
-                bool no_captures = (white_attacks & black_pawn_bb) == 0 && (black_attacks & white_pawn_bb) == 0;
-                if (white_blocked && black_blocked && no_captures) {
-                    bool has_open_file = false;
-                    Bitboard all_pawns = white_pawn_bb | black_pawn_bb;
-                    for (int f = 0; f < 8; f++) {
-                        Bitboard file_mask = Bitboards::FileA << f;
-                        if ((all_pawns & file_mask) == 0) {
-                            has_open_file = true;
-                            break;
-                        }
-                    }
-                    if (!has_open_file) {
-                        scale = std::min(scale, Params.SCALE_FORTRESS);
-                    }
-                }
+    // Simple fortress heuristic: locked pawn chains, no open files (the
+    // material entry has checked there are no major pieces)
+    bool is_fortress(const Position& pos) {
+        Bitboard white_pawn_bb = pos.pieces(PAWN, WHITE);
+        Bitboard black_pawn_bb = pos.pieces(PAWN, BLACK);
+        if (!white_pawn_bb || !black_pawn_bb) return false;
+
+        Bitboard white_attacks = 0;
+        Bitboard black_attacks = 0;
+        Bitboard wp = white_pawn_bb;
+        Bitboard bp = black_pawn_bb;
+        while (wp) {
+            Square sq = (Square)Bitboards::pop_lsb(wp);
+            white_attacks |= Bitboards::get_pawn_attacks(sq, WHITE);
+        }
+        while (bp) {
+            Square sq = (Square)Bitboards::pop_lsb(bp);
+            black_attacks |= Bitboards::get_pawn_attacks(sq, BLACK);
+        }
+
+        Bitboard white_front = white_pawn_bb << 8;
+        Bitboard black_front = black_pawn_bb >> 8;
+        bool white_blocked = (white_front & ~black_pawn_bb) == 0;
+        bool black_blocked = (black_front & ~white_pawn_bb) == 0;
+        bool no_captures = (white_attacks & black_pawn_bb) == 0 && (black_attacks & white_pawn_bb) == 0;
+        if (!white_blocked || !black_blocked || !no_captures) return false;
+
+        Bitboard all_pawns = white_pawn_bb | black_pawn_bb;
+        for (int f = 0; f < 8; f++) {
+            Bitboard file_mask = Bitboards::FileA << f;
+            if ((all_pawns & file_mask) == 0) return false;
+        }
+        return true;
+    }
+
+    // ----------------------------------------------------------------------------
+    // Material Hash
+    // ----------------------------------------------------------------------------
+
+    const MaterialEntry& probe_material(const Position& pos) {
+        Key key = pos.material_key();
+        MaterialTable& table = material_table();
+        MaterialEntry& entry = table.slot(key);
+
+        if (entry.key == key) {
+#ifdef STATS
+            table.hits++;
+#endif
+            return entry;
+        }
+#ifdef STATS
+        table.misses++;
+#endif
+
+        int n[COLOR_NB][PIECE_TYPE_NB];
+        int phase = 0;
+        for (Color c : {WHITE, BLACK}) {
+            for (int pt = PAWN; pt <= KING; pt++) {
+                n[c][pt] = Bitboards::count(pos.pieces((PieceType)pt, c));
+                phase += n[c][pt] * Params.PHASE_WEIGHTS[pt];
             }
         }
+        int phase_clamped = std::clamp(phase, 0, 24);
 
-        return scale;
+        entry.key = key;
+        entry.phase = (uint8_t)phase_clamped;
+        entry.scale = (uint8_t)material_scale(n, phase_clamped);
+
+        // Bishop pair, worth more as pawns come off
+        int open_factor = 16 - std::min(16, n[WHITE][PAWN] + n[BLACK][PAWN]);
+        int mg = 0, eg = 0;
+        for (Color c : {WHITE, BLACK}) {
+            if (n[c][BISHOP] < 2) continue;
+            int sign = (c == WHITE) ? 1 : -1;
+            mg += (Params.BISHOP_PAIR_BONUS_MG + open_factor * Params.BISHOP_PAIR_OPEN_SCALE_MG) * sign;
+            eg += (Params.BISHOP_PAIR_BONUS_EG + open_factor * Params.BISHOP_PAIR_OPEN_SCALE_EG) * sign;
+        }
+        entry.imbalance_mg = (int16_t)mg;
+        entry.imbalance_eg = (int16_t)eg;
+
+        bool no_majors = !n[WHITE][ROOK] && !n[BLACK][ROOK] && !n[WHITE][QUEEN] && !n[BLACK][QUEEN];
+        entry.fortress_check = phase_clamped <= 12 && no_majors;
+        entry.ocb_check = phase_clamped < 12 && no_majors && n[WHITE][BISHOP] == 1 && n[BLACK][BISHOP] == 1
+            && !n[WHITE][KNIGHT] && !n[BLACK][KNIGHT];
+
+        Color strong = WHITE;
+        entry.endgame = Endgames::lookup(pos, strong);
+        entry.strong = (uint8_t)strong;
+        return entry;
     }
 
     // ----------------------------------------------------------------------------
@@ -368,10 +494,16 @@ namespace Eval {
     };
 
     int evaluate_hce(const Position& pos, int alpha, int beta) {
+        const MaterialEntry& material = probe_material(pos);
+        if (material.endgame) {
+            int v = material.endgame(pos, (Color)material.strong);
+            return pos.side_to_move() == material.strong ? v : -v;
+        }
+
         // 1. Setup & Pawn Eval
         int mg = pos.eval_mg();
         int eg = pos.eval_eg();
-        int phase = pos.eval_phase();
+        int phase = material.phase; // Already clamped to 0-24
 
         PawnEntry pawn_entry = evaluate_pawns(pos);
         mg += pawn_entry.score_mg;
@@ -636,12 +768,6 @@ namespace Eval {
                 }
             }
 
-            // Bishop Pair
-            if (Bitboards::count(pos.pieces(BISHOP, us)) >= 2) {
-                mg += Params.BISHOP_PAIR_BONUS_MG * us_sign;
-                eg += Params.BISHOP_PAIR_BONUS_EG * us_sign;
-            }
-
             // Passed Pawn Blockers
             Bitboard blocked_passed = pawn_entry.passed_front_mask[us] & occ;
             int blocked_count = Bitboards::count(blocked_passed);
@@ -649,18 +775,9 @@ namespace Eval {
             eg += blocked_count * Params.PASSED_PAWN_BLOCKER_PENALTY_EG * us_sign;
         }
 
-        int total_pawns = Bitboards::count(pos.pieces(PAWN));
-        int open_factor = 16 - std::min(16, total_pawns);
-        int bishop_pair_open_bonus_mg = open_factor * Params.BISHOP_PAIR_OPEN_SCALE_MG;
-        int bishop_pair_open_bonus_eg = open_factor * Params.BISHOP_PAIR_OPEN_SCALE_EG;
-        if (Bitboards::count(pos.pieces(BISHOP, WHITE)) >= 2) {
-            mg += bishop_pair_open_bonus_mg;
-            eg += bishop_pair_open_bonus_eg;
-        }
-        if (Bitboards::count(pos.pieces(BISHOP, BLACK)) >= 2) {
-            mg -= bishop_pair_open_bonus_mg;
-            eg -= bishop_pair_open_bonus_eg;
-        }
+        // Bishop pair
+        mg += material.imbalance_mg;
+        eg += material.imbalance_eg;
 
         for (Color us : {WHITE, BLACK}) {
             Color them = ~us;
@@ -855,32 +972,27 @@ namespace Eval {
         }
 
         // 4. Interpolate and Scale
-        int phase_clamped = std::clamp(phase, 0, 24);
+        int phase_clamped = phase;
         mg = clamp_score(mg, Params.CLAMP_MG);
         eg = clamp_score(eg, Params.CLAMP_EG);
         int score = (mg * phase_clamped + eg * (24 - phase_clamped)) / 24;
 
         // OCB (Opposite Colored Bishops) Scaling
-        // If endgame, and bishops are opposite colors.
-        if (phase_clamped < 12) { // Endgame-ish
-             if (Bitboards::count(pos.pieces(BISHOP, WHITE)) == 1 &&
-                 Bitboards::count(pos.pieces(BISHOP, BLACK)) == 1 &&
-                 Bitboards::count(pos.pieces(KNIGHT)) == 0 &&
-                 Bitboards::count(pos.pieces(ROOK)) == 0 &&
-                 Bitboards::count(pos.pieces(QUEEN)) == 0) {
-
-                 Square wb = (Square)Bitboards::lsb(pos.pieces(BISHOP, WHITE));
-                 Square bb = (Square)Bitboards::lsb(pos.pieces(BISHOP, BLACK));
-                 bool wb_light = Bitboards::check_bit(0x55AA55AA55AA55AAULL, wb);
-                 bool bb_light = Bitboards::check_bit(0x55AA55AA55AA55AAULL, bb);
-
-                 if (wb_light != bb_light) {
-                     score = score / 2; // Reduce score advantage in OCB
-                 }
-            }
+        if (material.ocb_check) {
+             Square wb = (Square)Bitboards::lsb(pos.pieces(BISHOP, WHITE));
+             Square bb = (Square)Bitboards::lsb(pos.pieces(BISHOP, BLACK));
+             bool wb_light = Bitboards::check_bit(0x55AA55AA55AA55AAULL, wb);
+             bool bb_light = Bitboards::check_bit(0x55AA55AA55AA55AAULL, bb);
+
+             if (wb_light != bb_light) {
+                 score = score / 2; // Reduce score advantage in OCB
+             }
         }
 
-        int scale = get_scale_factor(pos, phase_clamped);
+        int scale = material.scale;
+        if (material.fortress_check && is_fortress(pos)) {
+            scale = std::min(scale, Params.SCALE_FORTRESS);
+        }
         if (scale != 128) {
             score = (score * scale) / 128;
         }
@@ -935,7 +1047,14 @@ namespace Eval {
 
     int evaluate(const Position& pos, int alpha, int beta) {
         if (GlobalUseNNUE && NNUE::g_network) {
-             return NNUE::g_network->evaluate(pos, pos.nnue());
+             // The net gets the material table's endgame knowledge on top
+             const MaterialEntry& material = probe_material(pos);
+             if (material.endgame) {
+                 int v = material.endgame(pos, (Color)material.strong);
+                 return pos.side_to_move() == material.strong ? v : -v;
+             }
+             int v = NNUE::g_network->evaluate(pos, pos.nnue());
+             return material.scale == 128 ? v : v * material.scale / 128;
         }
         return evaluate_hce(pos, alpha, beta);
     }
@@ -945,4 +1064,22 @@ namespace Eval {
         std::cout << "trace," << s << "\n";
     }
 
+    uint64_t fingerprint() {
+        uint64_t h = 1469598103934665603ULL; // FNV-1a
+        auto mix = [&h](const void* data, size_t bytes) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < bytes; i++) h = (h ^ p[i]) * 1099511628211ULL;
+        };
+        bool nnue = GlobalUseNNUE && NNUE::g_network;
+        mix(&nnue, sizeof(nnue));
+        mix(&GlobalContempt, sizeof(GlobalContempt));
+        if (nnue) {
+            mix(&NNUE::g_network->weights, sizeof(NNUE::g_network->weights));
+            mix(&NNUE::g_network->heads, sizeof(NNUE::g_network->heads));
+        } else {
+            mix(&Params, sizeof(Params));
+        }
+        return h;
+    }
+
 }
@@ -3,12 +3,13 @@
 
 #include "position.h"
 #include "eval_params.h" // For load_params visibility or just declare it
+#include "endgame.h"
 
 namespace Eval {
 
     // Helper structs
     struct PawnEntry {
-        Key key;
+        Key key; // Pawn key ^ PAWN_KEY_SALT, so a zeroed slot never matches
         int score_mg;
         int score_eg;
         Bitboard passed_pawns[2];
@@ -16,6 +17,53 @@ namespace Eval {
         Bitboard passed_front_mask[2]; // Squares in front of passed pawns (one rank)
     };
 
+    // Everything that depends on the piece counts alone
+    struct MaterialEntry {
+        Key key;                 // Material key (never 0: kings count)
+        Endgames::EvalFn endgame; // Specialized evaluator, or nullptr
+        int16_t imbalance_mg;    // Bishop pair terms, White's view
+        int16_t imbalance_eg;
+        uint8_t phase;           // 0 (pawn ending) to 24
+        uint8_t scale;           // Out of 128, for drawish material
+        uint8_t strong;          // Color endgame() scores for
+        bool fortress_check;     // Pawn structure may lower scale further
+        bool ocb_check;          // One bishop each: halve if opposite colours
+    };
+
+    // Per-thread caches. Each search thread owns one of each (in its
+    // SearchWorker) and installs them with set_tables(); threads that never
+    // do (tuning, tools) get private 1 MB tables on first use. Pawn entries
+    // also see non-pawn blockers, so a shared table would make evals depend
+    // on thread timing.
+    template <typename Entry>
+    class HashTable {
+    public:
+        HashTable() = default;
+        ~HashTable();
+        HashTable(const HashTable&) = delete;
+        HashTable& operator=(const HashTable&) = delete;
+
+        void resize(size_t size_mb); // Power-of-two entry count, at most size_mb
+        void clear();
+        // Clears entries cached under older Params, see params_changed()
+        void sync_params() { if (params_version != ParamsVersion) clear(); }
+        size_t size_mb() const { return entries ? (mask + 1) * sizeof(Entry) / (1024 * 1024) : 0; }
+        Entry& slot(Key key) { return entries[key & mask]; }
+
+        uint64_t hits = 0; // Probe counters, STATS builds only
+        uint64_t misses = 0;
+
+    private:
+        Entry* entries = nullptr;
+        size_t mask = 0;
+        uint32_t params_version = 0;
+    };
+
+    using PawnTable = HashTable<PawnEntry>;
+    using MaterialTable = HashTable<MaterialEntry>;
+
+    void set_tables(PawnTable* pawns, MaterialTable* material); // For evals on the calling thread
+
     // Constants
     extern const int MG_VALS[6];
     extern const int EG_VALS[6];
@@ -28,9 +76,16 @@ namespace Eval {
     int evaluate(const Position& pos, int alpha = -32000, int beta = 32000);
     int evaluate_light(const Position& pos);
     void trace_eval(const Position& pos);
+    // Hash of everything static evals depend on (active net or HCE params,
+    // contempt); tags saved hash tables
+    uint64_t fingerprint();
+
+    // Pulls the pawn hash slot for pawn_key into cache (no-op under NNUE)
+    void prefetch_pawns(Key pawn_key);
 
     // Internal
     PawnEntry evaluate_pawns(const Position& pos);
+    const MaterialEntry& probe_material(const Position& pos);
 
 }
 
@@ -7,6 +7,11 @@
 namespace Eval {
 
     EvalParams Params;
+    uint32_t ParamsVersion = 0;
+
+    void params_changed() {
+        ParamsVersion++;
+    }
 
     // Default Values (Tuned Baseline)
     void init_params() {
@@ -231,11 +236,13 @@ namespace Eval {
         Params.BISHOP_PAIR_OPEN_SCALE_EG = 3;
         Params.CLAMP_MG = 3200;
         Params.CLAMP_EG = 3200;
+        params_changed();
     }
 
     bool load_params(const char* filename) {
         // Placeholder for JSON loader
         // Not strictly required for the patch to work, as defaults are set.
+        // A real loader must call params_changed() once Params are filled.
         return false;
     }
 
@@ -135,6 +135,11 @@ namespace Eval {
     void init_params(); // Set defaults
     bool load_params(const char* filename); // Load from JSON/file
 
+    // Bumped whenever Params change; pawn and material tables cache
+    // Params-weighted terms and clear themselves when it moves
+    extern uint32_t ParamsVersion;
+    void params_changed();
+
 }
 
 #endif // EVAL_PARAMS_H
@@ -1,6 +1,7 @@
 #include "eval_tune.h"
 #include "eval.h"
 #include "eval_params.h"
+#include "eval_util.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -361,7 +362,9 @@ namespace Eval {
 
             FeatureSet fs = extract(pos);
 
-            int eval = Eval::evaluate(pos);
+            // Clamped like datagen: known-win endgame scores are far outside
+            // anything the linear features can fit
+            int eval = EvalUtil::clamp_score_cp(Eval::evaluate(pos));
 
             int phase = 0;
             for (int pt = 0; pt < 6; pt++) {
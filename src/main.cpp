@@ -5,9 +5,15 @@
 #include <atomic>
 #include <vector>
 #include <optional>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include "position.h"
 #include "search.h"
+#include "search_params.h"
+#include "stats.h"
 #include "tt.h"
+#include "memory.h"
 #include "movegen.h"
 #include "perft.h"
 #include "eval/eval.h"
@@ -16,6 +22,7 @@
 #include "packed_board_io.h"
 #include "syzygy.h"
 #include "nnue/network.h"
+#include "numa.h"
 
 // Parse move string to uint16_t
 uint16_t parse_move(const Position& pos, const std::string& str) {
@@ -74,18 +81,46 @@ std::thread search_thread;
 // UCI Options
 int OptHash = 256;
 int OptThreads = 1;
+int OptSpinWaitUs = 0;
 int OptMoveOverhead = 10;
+int OptMultiPV = 1;
 int OptContempt = 0;
 std::string OptSyzygyPath = "";
 bool OptChess960 = false;
 bool OptNullMove = true;
-bool OptProbCut = true;
+bool OptProbCut = false; // Off until an SPRT shows a gain
 bool OptSingularExt = true;
 bool OptUseHistory = true;
 bool OptLargePages = false;
 bool OptUseNNUE = true;
 std::string OptNNUEArch = "classic";
 std::string OptNNUEFile = "";
+std::string OptThreadBinding = "none";
+std::string OptHashFile = "";
+bool OptDeterministic = false;
+QsTTPolicy OptQSearchTT = QsTTPolicy::Shared;
+int OptQSearchHash = 1;
+int OptPawnHash = 1;
+
+// Clearing a large hash can take seconds; say how long it took
+void report_tt_clear() {
+    std::cout << "info string hash clear " << TTable.size_mb() << " MB threads "
+              << TTable.last_clear_thread_count() << " time " << TTable.last_clear_ms() << " ms" << std::endl;
+}
+
+// Which page size the hash got: hugetlb pools are often not configured
+void report_tt_alloc() {
+    if (TTable.file_backed()) {
+        std::cout << "info string hash alloc " << TTable.size_mb() << " MB file " << OptHashFile
+                  << (TTable.restored_from_file() ? " restored" : " new") << std::endl;
+        if (TTable.restored_from_file()) return;
+    } else {
+        if (!OptHashFile.empty()) std::cout << "info string cannot map " << OptHashFile << ", using memory" << std::endl;
+        std::cout << "info string hash alloc " << TTable.size_mb() << " MB pages "
+                  << Memory::pages_name(TTable.pages()) << std::endl;
+    }
+    report_tt_clear();
+}
 
 void join_search() {
     Search::stop();
@@ -104,6 +139,195 @@ std::optional<PackedFormat> parse_packed_format(const std::string& value) {
     return std::nullopt;
 }
 
+// Bench positions: Startpos + 3 tactical positions
+const std::vector<std::string> BenchFens = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", // Kiwipete
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+};
+
+SearchLimits bench_limits(int depth) {
+    SearchLimits limits;
+    limits.depth = depth;
+    limits.use_nmp = OptNullMove;
+    limits.use_probcut = OptProbCut;
+    limits.use_singular = OptSingularExt;
+    limits.use_history = OptUseHistory;
+    limits.deterministic = OptDeterministic;
+    limits.qs_tt = OptQSearchTT;
+    limits.qs_hash_mb = OptQSearchHash;
+    limits.pawn_hash_mb = OptPawnHash;
+    return limits;
+}
+
+// Lazy SMP scaling: time-to-depth and nps over the bench positions for
+// 1, 2, 4, ... max_threads, each run starting from an empty TT.
+void smp_bench(int depth, int max_threads) {
+    int saved_threads = OptThreads;
+    long long base_ms = 0;
+    std::cout << "threads  time(ms)  ttd-speedup  nodes  nps\n";
+    for (int threads = 1;; threads = std::min(threads * 2, max_threads)) {
+        OptThreads = threads;
+        Search::clear();
+        long long total_nodes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& f : BenchFens) {
+            Position bench_pos;
+            bench_pos.set(f);
+            SearchLimits limits = bench_limits(depth);
+            limits.silent = true;
+            Search::search(bench_pos, limits);
+            total_nodes += Search::get_node_count();
+        }
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (threads == 1) base_ms = ms;
+        double speedup = (ms > 0) ? static_cast<double>(base_ms) / ms : 0.0;
+        std::cout << threads << "  " << ms << "  " << speedup << "  " << total_nodes
+                  << "  " << (ms > 0 ? total_nodes * 1000 / ms : 0) << "\n" << std::flush;
+        if (threads >= max_threads) break;
+    }
+    OptThreads = saved_threads;
+    Search::clear();
+}
+
+// "position" arguments: startpos | fen <fen>, then optional moves
+void set_position(Position& pos, std::istream& ss) {
+    std::string token;
+    ss >> token;
+    if (token == "startpos") {
+        pos.set_chess960(OptChess960);
+        pos.set_startpos();
+        ss >> token; // Check for 'moves'
+    } else if (token == "fen") {
+        std::string fen = "";
+        while (ss >> token && token != "moves") {
+            fen += token + " ";
+        }
+        pos.set_chess960(OptChess960);
+        pos.set(fen);
+    }
+
+    if (token == "moves") {
+        while (ss >> token) {
+            uint16_t m = parse_move(pos, token);
+            if (m != 0) pos.make_move(m);
+        }
+    }
+}
+
+// "go" arguments on top of the current options; searchmoves are parsed
+// against pos
+SearchLimits go_limits(std::istream& ss, const Position& pos) {
+    SearchLimits limits;
+    limits.move_overhead_ms = OptMoveOverhead;
+    limits.multi_pv = OptMultiPV;
+    limits.use_nmp = OptNullMove;
+    limits.use_probcut = OptProbCut;
+    limits.use_singular = OptSingularExt;
+    limits.use_history = OptUseHistory;
+    limits.deterministic = OptDeterministic;
+    limits.qs_tt = OptQSearchTT;
+    limits.qs_hash_mb = OptQSearchHash;
+    limits.pawn_hash_mb = OptPawnHash;
+
+    std::string token;
+    bool in_search_moves = false; // searchmoves runs until a token that is not a move
+    while (ss >> token) {
+        if (in_search_moves) {
+            uint16_t m = parse_move(pos, token);
+            if (m != 0) {
+                limits.search_moves.push_back(m);
+                continue;
+            }
+            in_search_moves = false;
+        }
+        if (token == "wtime") ss >> limits.time[WHITE];
+        else if (token == "btime") ss >> limits.time[BLACK];
+        else if (token == "winc") ss >> limits.inc[WHITE];
+        else if (token == "binc") ss >> limits.inc[BLACK];
+        else if (token == "depth") ss >> limits.depth;
+        else if (token == "nodes") ss >> limits.nodes;
+        else if (token == "movetime") ss >> limits.move_time;
+        else if (token == "movestogo") ss >> limits.movestogo;
+        else if (token == "infinite") limits.infinite = true;
+        else if (token == "ponder") limits.ponder = true;
+        else if (token == "searchmoves") in_search_moves = true;
+    }
+    return limits;
+}
+
+// Re-runs every go command of a recorded UCI session (position/go/ucinewgame
+// lines; bestmove lines, if present, are the recorded answers) and reports
+// time used against the budget and the clock, plus agreement with the
+// recorded moves. "go infinite" is skipped since it needs a stop.
+void replay_log(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "info string replay: cannot open " << path << std::endl;
+        return;
+    }
+
+    Position pos;
+    pos.set_chess960(OptChess960);
+    pos.set_startpos();
+
+    int searches = 0, over_maximum = 0, over_clock = 0, compared = 0, matched = 0;
+    long long used_total = 0, optimum_total = 0;
+    double worst_ratio = 0.0;
+    uint16_t last_move = 0;
+    bool awaiting_bestmove = false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string token;
+        if (!(ss >> token)) continue;
+
+        if (token == "ucinewgame") {
+            Search::clear();
+        } else if (token == "position") {
+            set_position(pos, ss);
+        } else if (token == "bestmove" && awaiting_bestmove) {
+            std::string recorded;
+            ss >> recorded;
+            compared++;
+            if (parse_move(pos, recorded) == last_move) matched++;
+            awaiting_bestmove = false;
+        } else if (token == "go") {
+            SearchLimits limits = go_limits(ss, pos);
+            if (limits.infinite) continue;
+            limits.silent = true;
+            limits.ponder = false; // Replayed as if the ponder move was played
+
+            SearchResult r = Search::search(pos, limits);
+            int clock = limits.time[pos.side_to_move()];
+            searches++;
+            used_total += r.elapsed_ms;
+            optimum_total += r.time_optimum_ms;
+            if (r.time_maximum_ms > 0) {
+                worst_ratio = std::max(worst_ratio, static_cast<double>(r.elapsed_ms) / r.time_maximum_ms);
+                if (r.elapsed_ms > r.time_maximum_ms) over_maximum++;
+            }
+            if (clock > 0 && r.elapsed_ms >= clock) over_clock++;
+            last_move = r.best_move;
+            awaiting_bestmove = true;
+
+            std::cout << "replay " << searches << ": clock " << clock
+                      << " optimum " << r.time_optimum_ms << " maximum " << r.time_maximum_ms
+                      << " used " << r.elapsed_ms << " depth " << r.depth_reached
+                      << " score " << r.best_score_cp << " nodes " << Search::get_node_count() << "\n";
+        }
+    }
+
+    std::cout << "Replay: " << searches << " searches, " << used_total << " ms used, "
+              << optimum_total << " ms optimum, worst used/maximum " << worst_ratio
+              << ", over maximum " << over_maximum << ", out of clock " << over_clock;
+    if (compared > 0) std::cout << ", same move as recorded " << matched << "/" << compared;
+    std::cout << std::endl;
+}
+
 bool parse_bool_value(const std::string& value, bool& out) {
     if (value == "1" || value == "true" || value == "yes" || value == "on") {
         out = true;
@@ -125,7 +349,7 @@ int main(int argc, char* argv[]) {
     Eval::init_params();
 
     // Initialize TT with default
-    TTable.set_large_pages(OptLargePages);
+    Memory::set_hugetlb(OptLargePages);
     TTable.resize(OptHash);
 
     // CLI Mode Check
@@ -280,6 +504,8 @@ int main(int argc, char* argv[]) {
                     cfg.sample_top_k = topk;
                     cfg.sample_top_n = topk;
                     j += 1;
+                } else if (opt == "--multipv") {
+                    cfg.use_multipv = true;
                 } else if (opt == "--temp-start" && j + 1 < argc) {
                     cfg.temp_start = std::stod(argv[j + 1]);
                     j += 1;
@@ -414,6 +640,10 @@ int main(int argc, char* argv[]) {
             OptLargePages = true;
         }
     }
+    if (OptLargePages) {
+        Memory::set_hugetlb(true);
+        TTable.resize(OptHash);
+    }
 
     Position pos;
     pos.set_startpos();
@@ -432,18 +662,33 @@ int main(int argc, char* argv[]) {
             std::cout << "id author Basti Dangca\n";
             std::cout << "option name Hash type spin default 256 min 1 max 65536\n";
             std::cout << "option name Threads type spin default 1 min 1 max 64\n";
+            std::cout << "option name ThreadBinding type combo default none var none var numa var core\n";
+            std::cout << "option name SpinWaitUs type spin default 0 min 0 max 1000000\n";
+            std::cout << "option name Deterministic type check default false\n";
+            std::cout << "option name QSearchTT type combo default shared var shared var local var split\n";
+            std::cout << "option name QSearchHash type spin default 1 min 1 max 64\n";
+            std::cout << "option name PawnHash type spin default 1 min 1 max 256\n";
             std::cout << "option name MoveOverhead type spin default 10 min 0 max 5000\n";
+            std::cout << "option name MultiPV type spin default 1 min 1 max 256\n";
+            std::cout << "option name Ponder type check default false\n";
             std::cout << "option name Contempt type spin default 0 min -200 max 200\n";
             std::cout << "option name SyzygyPath type string default <empty>\n";
             std::cout << "option name UCI_Chess960 type check default false\n";
             std::cout << "option name NullMove type check default true\n";
-            std::cout << "option name ProbCut type check default true\n";
+            std::cout << "option name ProbCut type check default false\n";
             std::cout << "option name SingularExt type check default true\n";
             std::cout << "option name UseHistory type check default true\n";
             std::cout << "option name LargePages type check default false\n";
+            std::cout << "option name HashFile type string default <empty>\n";
             std::cout << "option name Use NNUE type check default true\n";
             std::cout << "option name nnue_arch type string default classic\n";
             std::cout << "option name nnue_file type string default <empty>\n";
+#ifdef TUNE
+            for (const auto& t : SearchParams::tunables()) {
+                std::cout << "option name " << t.name << " type spin default " << t.default_value
+                          << " min " << t.min << " max " << t.max << "\n";
+            }
+#endif
             std::cout << "uciok\n" << std::flush;
         } else if (token == "isready") {
             std::cout << "readyok\n" << std::flush;
@@ -469,10 +714,33 @@ int main(int argc, char* argv[]) {
                         OptHash = std::stoi(value);
                         join_search();
                         TTable.resize(OptHash);
+                        report_tt_alloc();
                     } else if (name == "Threads") {
                         OptThreads = std::stoi(value);
+                        TTable.set_clear_threads(OptThreads);
+                    } else if (name == "ThreadBinding") {
+                        Numa::Binding mode;
+                        if (Numa::parse_binding(value, mode)) {
+                            OptThreadBinding = value;
+                            join_search();
+                            Numa::set_binding(mode);
+                        }
+                    } else if (name == "Deterministic") {
+                        OptDeterministic = (value == "true");
+                    } else if (name == "QSearchTT") {
+                        if (value == "shared") OptQSearchTT = QsTTPolicy::Shared;
+                        else if (value == "local") OptQSearchTT = QsTTPolicy::Local;
+                        else if (value == "split") OptQSearchTT = QsTTPolicy::Split;
+                    } else if (name == "QSearchHash") {
+                        OptQSearchHash = std::clamp(std::stoi(value), 1, 64);
+                    } else if (name == "PawnHash") {
+                        OptPawnHash = std::clamp(std::stoi(value), 1, 256);
+                    } else if (name == "SpinWaitUs") {
+                        OptSpinWaitUs = std::stoi(value);
                     } else if (name == "MoveOverhead") {
                         OptMoveOverhead = std::stoi(value);
+                    } else if (name == "MultiPV") {
+                        OptMultiPV = std::clamp(std::stoi(value), 1, 256);
                     } else if (name == "Contempt") {
                         OptContempt = std::stoi(value);
                         Eval::set_contempt(OptContempt);
@@ -494,8 +762,16 @@ int main(int argc, char* argv[]) {
                     } else if (name == "LargePages") {
                         OptLargePages = (value == "true");
                         join_search();
-                        TTable.set_large_pages(OptLargePages);
+                        Memory::set_hugetlb(OptLargePages);
                         TTable.resize(OptHash);
+                        report_tt_alloc();
+                    } else if (name == "HashFile") {
+                        // Set after the net options: the file is tagged with the current eval
+                        OptHashFile = (value == "<empty>") ? "" : value;
+                        join_search();
+                        TTable.set_backing_file(OptHashFile, Eval::fingerprint());
+                        TTable.resize(OptHash);
+                        report_tt_alloc();
                     } else if (name == "Use NNUE") {
                         OptUseNNUE = (value == "true");
                         Eval::set_use_nnue(OptUseNNUE);
@@ -505,60 +781,36 @@ int main(int argc, char* argv[]) {
                     } else if (name == "nnue_file") {
                         OptNNUEFile = value;
                         Eval::init_nnue(OptNNUEArch, OptNNUEFile);
+                    } else if (name == "Ponder") {
+                        // Nothing to set: pondering is driven by go ponder / ponderhit,
+                        // and GUIs may send this while a ponder search runs
                     }
+#ifdef TUNE
+                    else {
+                        join_search();
+                        try {
+                            SearchParams::set_tunable(name, std::stoi(value));
+                        } catch (...) {}
+                    }
+#endif
                 }
             }
         } else if (token == "ucinewgame") {
             join_search();
-            Search::clear();
-            TTable.clear();
+            Search::clear(); // Includes the TT
+            report_tt_clear();
         } else if (token == "position") {
             join_search(); // Safety
-            ss >> token;
-            if (token == "startpos") {
-                pos.set_chess960(OptChess960);
-                pos.set_startpos();
-                ss >> token; // Check for 'moves'
-            } else if (token == "fen") {
-                std::string fen = "";
-                while (ss >> token && token != "moves") {
-                    fen += token + " ";
-                }
-                pos.set_chess960(OptChess960);
-                pos.set(fen);
-            }
-
-            if (token == "moves") {
-                while (ss >> token) {
-                    uint16_t m = parse_move(pos, token);
-                    if (m != 0) pos.make_move(m);
-                }
-            }
+            set_position(pos, ss);
         } else if (token == "go") {
             join_search(); // Ensure prev search stopped
-            SearchLimits limits;
-            limits.move_overhead_ms = OptMoveOverhead;
-            limits.use_nmp = OptNullMove;
-            limits.use_probcut = OptProbCut;
-            limits.use_singular = OptSingularExt;
-            limits.use_history = OptUseHistory;
-
-            while (ss >> token) {
-                if (token == "wtime") ss >> limits.time[WHITE];
-                else if (token == "btime") ss >> limits.time[BLACK];
-                else if (token == "winc") ss >> limits.inc[WHITE];
-                else if (token == "binc") ss >> limits.inc[BLACK];
-                else if (token == "depth") ss >> limits.depth;
-                else if (token == "nodes") ss >> limits.nodes;
-                else if (token == "movetime") ss >> limits.move_time;
-                else if (token == "movestogo") ss >> limits.movestogo;
-                else if (token == "infinite") limits.infinite = true;
-            }
-
+            SearchLimits limits = go_limits(ss, pos);
             search_thread = std::thread(Search::start, std::ref(pos), limits);
         } else if (token == "stop") {
             Search::stop();
             // Thread will print bestmove and exit loop
+        } else if (token == "ponderhit") {
+            Search::ponderhit();
         } else if (token == "quit") {
             join_search();
             break;
@@ -573,36 +825,99 @@ int main(int argc, char* argv[]) {
         } else if (token == "bench") {
              join_search();
              // Simple bench
-             // Startpos + 3 tactical positions
-             std::vector<std::string> fens = {
-                 "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
-                 "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", // Kiwipete
-                 "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
-                 "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
-             };
-
              long long total_nodes = 0;
+             long long latency_total_us = 0;
+             long long latency_max_us = 0;
              auto bench_start = std::chrono::steady_clock::now();
+             Search::reset_stats();
 
-             for (const auto& f : fens) {
+             for (const auto& f : BenchFens) {
                  pos.set(f);
-                 SearchLimits limits;
-                 limits.depth = 10;
-                 // Use globals
-                 limits.use_nmp = OptNullMove;
-                 limits.use_probcut = OptProbCut;
-                 limits.use_singular = OptSingularExt;
-                 limits.use_history = OptUseHistory;
+                 SearchLimits limits = bench_limits(10);
 
                  // Run in this thread
                  Search::start(pos, limits); // This loops over depths.
                  total_nodes += Search::get_node_count();
+                 long long latency_us = Search::get_start_latency_us();
+                 latency_total_us += latency_us;
+                 latency_max_us = std::max(latency_max_us, latency_us);
              }
 
              auto bench_end = std::chrono::steady_clock::now();
              long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(bench_end - bench_start).count();
 
              std::cout << "Bench: " << total_nodes << " nodes " << ms << " ms " << (ms > 0 ? total_nodes * 1000 / ms : 0) << " nps\n";
+             std::cout << "Start latency: " << latency_total_us / (long long)BenchFens.size()
+                       << " us avg " << latency_max_us << " us max (search start to first node, slowest thread)\n";
+             if (Stats::enabled) {
+                 Stats::Counters counters = Search::stats();
+                 Stats::print_table(std::cout, counters);
+                 Stats::print_json(std::cout, counters);
+             }
+        } else if (token == "stats") {
+             // stats [json|reset]: counters summed over threads since the last reset
+             std::string arg;
+             ss >> arg;
+             if (!Stats::enabled) {
+                 std::cout << "info string stats not compiled in; build with make stats" << std::endl;
+             } else if (arg == "reset") {
+                 join_search();
+                 Search::reset_stats();
+             } else if (arg == "json") {
+                 Stats::print_json(std::cout, Search::stats());
+             } else {
+                 Stats::print_table(std::cout, Search::stats());
+             }
+        } else if (token == "tuneparams") {
+             // tuneparams [json]: SPSA config for OpenBench, or weather-factory JSON
+             std::string format;
+             ss >> format;
+             SearchParams::print_tunables(std::cout, format == "json");
+        } else if (token == "replay") {
+             // replay <uci log>: time usage of recorded go commands
+             join_search();
+             std::string path;
+             std::getline(ss >> std::ws, path);
+             replay_log(path);
+        } else if (token == "savehash" || token == "loadhash") {
+             // savehash|loadhash <file>: TT contents, tagged with the current eval
+             join_search();
+             std::string path;
+             std::getline(ss >> std::ws, path);
+             std::string error;
+             auto start = std::chrono::steady_clock::now();
+             bool ok = (token == "savehash") ? TTable.save(path, Eval::fingerprint(), error)
+                                             : TTable.load(path, Eval::fingerprint(), error);
+             long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+             if (ok) {
+                 OptHash = (int)TTable.size_mb();
+                 std::cout << "info string " << token << " " << path << " " << OptHash << " MB time " << ms << " ms" << std::endl;
+             } else {
+                 std::cout << "info string " << token << " failed: " << error << std::endl;
+             }
+        } else if (token == "hashstats") {
+             // hashstats: TT occupancy by age and depth, and a Hash suggestion
+             join_search();
+             std::cout << "info string hashfull " << TTable.hashfull() << std::endl;
+             print_occupancy(std::cout, TTable);
+        }
+#ifndef NDEBUG
+        else if (token == "ttstress") {
+             // ttstress [threads] [ms]: concurrent probe/store on a private TT (make debug only)
+             join_search();
+             int threads = 4;
+             int ms = 1000;
+             ss >> threads >> ms;
+             TranspositionTable::stress_test(std::clamp(threads, 1, 256), std::max(ms, 1));
+        }
+#endif
+        else if (token == "smpbench") {
+             // smpbench [depth] [max_threads]
+             join_search();
+             int depth = 12;
+             int max_threads = 64;
+             ss >> depth >> max_threads;
+             smp_bench(depth, std::clamp(max_threads, 1, 64));
         } else if (token == "tune") {
              ss >> token; // "fen" or subcommand
              if (token == "fen") {
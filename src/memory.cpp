@@ -0,0 +1,172 @@
+#include "memory.h"
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace Memory {
+
+void* alloc_aligned(size_t bytes, size_t alignment) {
+#if defined(_WIN32)
+    return _aligned_malloc(bytes, alignment);
+#else
+    void* mem = nullptr;
+    if (posix_memalign(&mem, alignment, bytes) != 0) return nullptr;
+    return mem;
+#endif
+}
+
+void free_aligned(void* ptr) {
+    if (!ptr) return;
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+namespace {
+
+bool use_hugetlb = false;
+
+// How each alloc_large block has to be released
+struct Block {
+    size_t bytes;
+    Pages pages;
+};
+std::mutex blocks_mutex;
+
+// Never destroyed: global tables are freed during static destruction
+std::unordered_map<void*, Block>& blocks() {
+    static auto* map = new std::unordered_map<void*, Block>();
+    return *map;
+}
+
+size_t round_up(size_t bytes, size_t unit) {
+    return (bytes + unit - 1) / unit * unit;
+}
+
+void* map_hugetlb(size_t bytes, Pages pages, size_t& mapped) {
+#if defined(_WIN32)
+    if (pages != Pages::Huge2M) return nullptr;
+    size_t page = GetLargePageMinimum();
+    if (page == 0) return nullptr;
+    mapped = round_up(bytes, page);
+    return VirtualAlloc(nullptr, mapped, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+#elif defined(__linux__) && defined(MAP_HUGETLB)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    size_t page = 2ULL * 1024 * 1024;
+    if (pages == Pages::Huge1G) {
+#if defined(MAP_HUGE_1GB)
+        flags |= MAP_HUGE_1GB;
+        page = 1ULL << 30;
+#else
+        return nullptr;
+#endif
+    }
+    mapped = round_up(bytes, page);
+    void* mem = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return mem == MAP_FAILED ? nullptr : mem;
+#else
+    (void)bytes;
+    (void)pages;
+    (void)mapped;
+    return nullptr;
+#endif
+}
+
+// madvise succeeds on kernels with THP compiled in even when it is turned off
+bool thp_available() {
+#if defined(__linux__)
+    static const bool available = [] {
+        std::ifstream f("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string mode;
+        return std::getline(f, mode) && mode.find("[never]") == std::string::npos;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+const char* pages_name(Pages pages) {
+    switch (pages) {
+        case Pages::Huge1G: return "hugetlb-1g";
+        case Pages::Huge2M: return "hugetlb-2m";
+        case Pages::Transparent: return "thp";
+        default: return "standard";
+    }
+}
+
+void set_hugetlb(bool enabled) {
+    use_hugetlb = enabled;
+}
+
+bool hugetlb() {
+    return use_hugetlb;
+}
+
+void* alloc_large(size_t bytes, bool allow_hugetlb, Pages* used) {
+    void* mem = nullptr;
+    Block block{bytes, Pages::Standard};
+
+    if (use_hugetlb && allow_hugetlb) {
+        // 1 GB pages only when the rounding waste stays below a quarter
+        if (bytes >= (3ULL << 30) / 4) mem = map_hugetlb(bytes, Pages::Huge1G, block.bytes);
+        if (mem) {
+            block.pages = Pages::Huge1G;
+        } else if ((mem = map_hugetlb(bytes, Pages::Huge2M, block.bytes))) {
+            block.pages = Pages::Huge2M;
+        }
+    }
+
+    if (!mem) {
+        block.bytes = round_up(bytes, LARGE_PAGE_ALIGN);
+        mem = alloc_aligned(block.bytes, LARGE_PAGE_ALIGN);
+        if (!mem) return nullptr;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (thp_available() && madvise(mem, block.bytes, MADV_HUGEPAGE) == 0) block.pages = Pages::Transparent;
+#endif
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(blocks_mutex);
+        blocks()[mem] = block;
+    }
+    if (used) *used = block.pages;
+    return mem;
+}
+
+void free_large(void* ptr) {
+    if (!ptr) return;
+    Block block;
+    {
+        std::lock_guard<std::mutex> lk(blocks_mutex);
+        auto it = blocks().find(ptr);
+        if (it == blocks().end()) return;
+        block = it->second;
+        blocks().erase(it);
+    }
+
+    if (block.pages == Pages::Huge1G || block.pages == Pages::Huge2M) {
+#if defined(_WIN32)
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        munmap(ptr, block.bytes);
+#endif
+    } else {
+        free_aligned(ptr);
+    }
+}
+
+} // namespace Memory
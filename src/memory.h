@@ -0,0 +1,36 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+
+namespace Memory {
+
+    // Alignment used for large per-thread and shared tables
+    constexpr size_t LARGE_PAGE_ALIGN = 2ULL * 1024 * 1024;
+
+    void* alloc_aligned(size_t bytes, size_t alignment);
+    void free_aligned(void* ptr);
+
+    // Page backing obtained by alloc_large, best first
+    enum class Pages {
+        Huge1G,      // MAP_HUGETLB 1 GB pages
+        Huge2M,      // MAP_HUGETLB 2 MB pages (Windows: MEM_LARGE_PAGES)
+        Transparent, // 2 MB aligned, madvise(MADV_HUGEPAGE)
+        Standard
+    };
+    const char* pages_name(Pages pages);
+
+    // Explicit huge pages need a preconfigured pool (LargePages option);
+    // transparent huge pages are always tried
+    void set_hugetlb(bool enabled);
+    bool hugetlb();
+
+    // Allocation for big tables: 1G then 2M hugetlb pages (if enabled and
+    // allow_hugetlb), then THP, then standard pages. The memory is not zeroed.
+    // Returns nullptr on failure; free with free_large.
+    void* alloc_large(size_t bytes, bool allow_hugetlb = true, Pages* used = nullptr);
+    void free_large(void* ptr);
+
+}
+
+#endif // MEMORY_H
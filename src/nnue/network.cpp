@@ -1,8 +1,10 @@
 #include "network.h"
+#include "../memory.h"
 #include <fstream>
 #include <iostream>
 #include <cmath>
 #include <cstring>
+#include <new>
 #include <vector>
 
 #ifdef __AVX2__
@@ -13,6 +15,16 @@ namespace NNUE {
 
     Network* g_network = nullptr;
 
+    void* Network::operator new(size_t size) {
+        void* mem = Memory::alloc_large(size);
+        if (!mem) throw std::bad_alloc();
+        return mem;
+    }
+
+    void Network::operator delete(void* ptr) {
+        Memory::free_large(ptr);
+    }
+
     bool Network::load(const std::string& filename) {
         std::ifstream file(filename, std::ios::binary);
         if (!file.is_open()) {
@@ -38,6 +38,11 @@ namespace NNUE {
 
         HeadWeights heads;
 
+        // ~3 MB of feature weights read on every accumulator update; keep
+        // them on huge pages when possible
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr);
+
         bool load(const std::string& filename);
 
         // Evaluate position
@@ -0,0 +1,180 @@
+#include "numa.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Numa {
+
+namespace {
+
+Binding g_binding = Binding::None;
+
+#if defined(__linux__)
+constexpr int MPOL_INTERLEAVE_MODE = 3;
+constexpr unsigned MPOL_MF_MOVE_FLAG = 1u << 1;
+#endif
+
+// Parses a sysfs cpulist such as "0-3,8-11"
+std::vector<int> parse_cpulist(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        try {
+            if (dash == std::string::npos) {
+                cpus.push_back(std::stoi(range));
+            } else {
+                int lo = std::stoi(range.substr(0, dash));
+                int hi = std::stoi(range.substr(dash + 1));
+                for (int c = lo; c <= hi; c++) cpus.push_back(c);
+            }
+        } catch (...) {
+            // Ignore malformed entries
+        }
+    }
+    return cpus;
+}
+
+Topology read_topology() {
+    Topology topo;
+#if defined(__linux__)
+    // Node ids can be sparse; probe a generous range
+    for (int node = 0; node < 1024; node++) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!in) continue;
+        std::string line;
+        std::getline(in, line);
+        std::vector<int> cpus = parse_cpulist(line);
+        if (cpus.empty()) continue; // Memory-only node
+        topo.node_ids.push_back(node);
+        topo.node_cpus.push_back(cpus);
+    }
+#endif
+    if (topo.node_cpus.empty()) {
+        unsigned n = std::thread::hardware_concurrency();
+        std::vector<int> cpus;
+        for (unsigned c = 0; c < (n ? n : 1); c++) cpus.push_back((int)c);
+        topo.node_ids.push_back(0);
+        topo.node_cpus.push_back(cpus);
+    }
+    return topo;
+}
+
+} // namespace
+
+const Topology& topology() {
+    static const Topology topo = read_topology();
+    return topo;
+}
+
+int node_count() {
+    return (int)topology().node_cpus.size();
+}
+
+void set_binding(Binding mode) {
+    g_binding = mode;
+}
+
+Binding binding() {
+    return g_binding;
+}
+
+bool parse_binding(const std::string& name, Binding& out) {
+    if (name == "none") { out = Binding::None; return true; }
+    if (name == "numa") { out = Binding::Node; return true; }
+    if (name == "core") { out = Binding::Core; return true; }
+    return false;
+}
+
+void bind_thread(int thread_idx) {
+    if (g_binding == Binding::None) return;
+#if defined(__linux__)
+    const Topology& topo = topology();
+    std::vector<int> cpus;
+    if (g_binding == Binding::Node) {
+        cpus = topo.node_cpus[thread_idx % topo.node_cpus.size()];
+    } else {
+        // Round-robin over nodes so consecutive threads spread across sockets
+        std::vector<int> order;
+        size_t widest = 0;
+        for (const auto& n : topo.node_cpus) widest = std::max(widest, n.size());
+        for (size_t i = 0; i < widest; i++) {
+            for (const auto& n : topo.node_cpus) {
+                if (i < n.size()) order.push_back(n[i]);
+            }
+        }
+        cpus.push_back(order[thread_idx % order.size()]);
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)thread_idx;
+#endif
+}
+
+ScopedBinding::ScopedBinding(int thread_idx) {
+    if (g_binding == Binding::None) return;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &set)) saved_cpus.push_back(c);
+        }
+    }
+#endif
+    bind_thread(thread_idx);
+}
+
+ScopedBinding::~ScopedBinding() {
+    if (saved_cpus.empty()) return;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : saved_cpus) CPU_SET(c, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+void interleave(void* ptr, size_t bytes) {
+#if defined(__linux__)
+    const Topology& topo = topology();
+    if (topo.node_ids.size() <= 1 || !ptr || bytes == 0) return;
+
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) return;
+    uintptr_t begin = ((uintptr_t)ptr + page - 1) & ~(uintptr_t)(page - 1);
+    uintptr_t end = ((uintptr_t)ptr + bytes) & ~(uintptr_t)(page - 1);
+    if (end <= begin) return;
+
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))] = {};
+    const size_t bits = 8 * sizeof(unsigned long);
+    for (int node : topo.node_ids) {
+        if (node < 1024) mask[node / bits] |= 1UL << (node % bits);
+    }
+    // Best effort: a failure just leaves the default first-touch placement
+    syscall(SYS_mbind, (void*)begin, (unsigned long)(end - begin), MPOL_INTERLEAVE_MODE,
+            mask, (unsigned long)(sizeof(mask) * 8), MPOL_MF_MOVE_FLAG);
+#else
+    (void)ptr;
+    (void)bytes;
+#endif
+}
+
+} // namespace Numa
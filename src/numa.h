@@ -0,0 +1,50 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Numa {
+
+    enum class Binding {
+        None, // Leave placement to the OS scheduler
+        Node, // Bind thread i to every CPU of node (i % nodes)
+        Core  // Bind thread i to a single CPU, nodes filled round-robin
+    };
+
+    struct Topology {
+        std::vector<int> node_ids;               // sysfs node numbers
+        std::vector<std::vector<int>> node_cpus; // CPU ids per node
+    };
+
+    // Topology read once from /sys/devices/system/node
+    const Topology& topology();
+    int node_count();
+
+    void set_binding(Binding mode);
+    Binding binding();
+    bool parse_binding(const std::string& name, Binding& out);
+
+    // Pins the calling thread according to the current binding mode
+    void bind_thread(int thread_idx);
+
+    // bind_thread() for a thread the pool only borrows: the previous
+    // affinity comes back when this goes out of scope
+    class ScopedBinding {
+    public:
+        explicit ScopedBinding(int thread_idx);
+        ~ScopedBinding();
+        ScopedBinding(const ScopedBinding&) = delete;
+        ScopedBinding& operator=(const ScopedBinding&) = delete;
+
+    private:
+        std::vector<int> saved_cpus; // Empty: nothing to restore
+    };
+
+    // Spreads the pages of [ptr, ptr + bytes) round-robin over all nodes
+    void interleave(void* ptr, size_t bytes);
+
+}
+
+#endif // NUMA_H
@@ -107,6 +107,10 @@ void Position::put_piece(Piece p, Square s) {
     Bitboards::set_bit(color_bb[p / 6], s);
     st_key ^= Zobrist::psq[p][s];
     if ((p % 6) == PAWN) p_key ^= Zobrist::psq[p][s];
+    else np_key[p / 6] ^= Zobrist::psq[p][s];
+    // Material key: one psq key per piece by its index among its kind, so a
+    // move that keeps the counts leaves it unchanged
+    m_key ^= Zobrist::psq[p][Bitboards::count(piece_bb[p % 6] & color_bb[p / 6]) - 1];
 }
 
 void Position::remove_piece(Square s) {
@@ -125,6 +129,8 @@ void Position::remove_piece(Square s) {
     Bitboards::clear_bit(color_bb[p / 6], s);
     st_key ^= Zobrist::psq[p][s];
     if ((p % 6) == PAWN) p_key ^= Zobrist::psq[p][s];
+    else np_key[p / 6] ^= Zobrist::psq[p][s];
+    m_key ^= Zobrist::psq[p][Bitboards::count(piece_bb[p % 6] & color_bb[p / 6])];
 }
 
 void Position::move_piece(Square from, Square to) {
@@ -150,6 +156,8 @@ void Position::set(const std::string& fen) {
     halfmove_clock = 0;
     st_key = 0;
     p_key = 0;
+    np_key[WHITE] = np_key[BLACK] = 0;
+    m_key = 0;
     eval_mg_acc = 0;
     eval_eg_acc = 0;
     eval_phase_acc = 0;
@@ -283,7 +291,7 @@ void Position::set(const std::string& fen) {
             assign_standard_rook(BLACK, 1, 8, FILE_A);
         }
     }
-    st_key ^= castling_key();
+    st_key ^= castling_key(castling);
 
     // 4. EP
     ss >> token;
@@ -324,6 +332,9 @@ void Position::set(const std::string& fen) {
     StateInfo si;
     si.key = st_key;
     si.pawn_key = p_key;
+    si.non_pawn_key[WHITE] = np_key[WHITE];
+    si.non_pawn_key[BLACK] = np_key[BLACK];
+    si.material_key = m_key;
     si.castling = castling;
     std::memcpy(si.castle_rook_from, castle_rook_from, sizeof(castle_rook_from));
     si.ep_square = ep_square;
@@ -362,6 +373,9 @@ void Position::make_move(uint16_t move) {
     StateInfo si;
     si.key = st_key;
     si.pawn_key = p_key;
+    si.non_pawn_key[WHITE] = np_key[WHITE];
+    si.non_pawn_key[BLACK] = np_key[BLACK];
+    si.material_key = m_key;
     si.castling = castling;
     std::memcpy(si.castle_rook_from, castle_rook_from, sizeof(castle_rook_from));
     si.ep_square = ep_square;
@@ -469,21 +483,9 @@ void Position::make_move(uint16_t move) {
     }
 
     // Update Castling Rights
-    st_key ^= castling_key();
-    if (pt == KING) {
-        if (side == WHITE) castling &= ~3;
-        else castling &= ~12;
-    }
-    // Rooks moved or captured
-    auto check_rook = [&](Square sq) {
-        if (sq == castle_rook_from[WHITE][0]) castling &= ~1;
-        else if (sq == castle_rook_from[WHITE][1]) castling &= ~2;
-        else if (sq == castle_rook_from[BLACK][0]) castling &= ~4;
-        else if (sq == castle_rook_from[BLACK][1]) castling &= ~8;
-    };
-    check_rook(from);
-    check_rook(to);
-    st_key ^= castling_key();
+    st_key ^= castling_key(castling);
+    castling = castling_after(from, to, pt);
+    st_key ^= castling_key(castling);
 
     // Update EP
     st_key ^= Zobrist::enpassant[ep_square];
@@ -512,6 +514,9 @@ void Position::make_null_move() {
     StateInfo si;
     si.key = st_key;
     si.pawn_key = p_key;
+    si.non_pawn_key[WHITE] = np_key[WHITE];
+    si.non_pawn_key[BLACK] = np_key[BLACK];
+    si.material_key = m_key;
     si.castling = castling;
     std::memcpy(si.castle_rook_from, castle_rook_from, sizeof(castle_rook_from));
     si.ep_square = ep_square;
@@ -546,6 +551,9 @@ void Position::unmake_null_move() {
     rule50 = si.rule50;
     st_key = si.key;
     p_key = si.pawn_key;
+    np_key[WHITE] = si.non_pawn_key[WHITE];
+    np_key[BLACK] = si.non_pawn_key[BLACK];
+    m_key = si.material_key;
     std::memcpy(castle_rook_from, si.castle_rook_from, sizeof(castle_rook_from));
     eval_mg_acc = si.eval_mg;
     eval_eg_acc = si.eval_eg;
@@ -602,6 +610,9 @@ void Position::unmake_move(uint16_t move) {
     rule50 = si.rule50;
     st_key = si.key;
     p_key = si.pawn_key;
+    np_key[WHITE] = si.non_pawn_key[WHITE];
+    np_key[BLACK] = si.non_pawn_key[BLACK];
+    m_key = si.material_key;
     eval_mg_acc = si.eval_mg;
     eval_eg_acc = si.eval_eg;
     eval_phase_acc = si.eval_phase;
@@ -773,12 +784,78 @@ std::string Position::fen() const {
     return out;
 }
 
-Key Position::castling_key() const {
-    Key key = Zobrist::castle[castling];
-    if (castling & 1) key ^= Zobrist::castle_rook[WHITE][0][castle_rook_from[WHITE][0]];
-    if (castling & 2) key ^= Zobrist::castle_rook[WHITE][1][castle_rook_from[WHITE][1]];
-    if (castling & 4) key ^= Zobrist::castle_rook[BLACK][0][castle_rook_from[BLACK][0]];
-    if (castling & 8) key ^= Zobrist::castle_rook[BLACK][1][castle_rook_from[BLACK][1]];
+Key Position::castling_key(int rights) const {
+    Key key = Zobrist::castle[rights];
+    if (rights & 1) key ^= Zobrist::castle_rook[WHITE][0][castle_rook_from[WHITE][0]];
+    if (rights & 2) key ^= Zobrist::castle_rook[WHITE][1][castle_rook_from[WHITE][1]];
+    if (rights & 4) key ^= Zobrist::castle_rook[BLACK][0][castle_rook_from[BLACK][0]];
+    if (rights & 8) key ^= Zobrist::castle_rook[BLACK][1][castle_rook_from[BLACK][1]];
+    return key;
+}
+
+// Rights left after the side to move plays a pt from `from` to `to`: king
+// moves lose both, rooks lose theirs when they move or are captured
+int Position::castling_after(Square from, Square to, PieceType pt) const {
+    int rights = castling;
+    if (pt == KING) rights &= (side == WHITE) ? ~3 : ~12;
+    for (Square sq : {from, to}) {
+        if (sq == castle_rook_from[WHITE][0]) rights &= ~1;
+        else if (sq == castle_rook_from[WHITE][1]) rights &= ~2;
+        else if (sq == castle_rook_from[BLACK][0]) rights &= ~4;
+        else if (sq == castle_rook_from[BLACK][1]) rights &= ~8;
+    }
+    return rights;
+}
+
+// Mirrors the key updates of make_move without touching the board
+Key Position::key_after(uint16_t move) const {
+    Square to = (Square)(move & 0x3F);
+    Square from = (Square)((move >> 6) & 0x3F);
+    int flag = (move >> 12);
+    Piece p = board[from];
+    PieceType pt = (PieceType)(p % 6);
+
+    Key key = st_key ^ Zobrist::side ^ Zobrist::psq[p][from];
+    if (flag == 5) {
+        Square capture_sq = (side == WHITE) ? (to + SOUTH) : (to + NORTH);
+        key ^= Zobrist::psq[board[capture_sq]][capture_sq];
+    } else if ((flag & 4) && board[to] != NO_PIECE) {
+        key ^= Zobrist::psq[board[to]][to];
+    }
+    Piece placed = (flag & 8) ? (Piece)(((flag & 3) + 1) + (side == WHITE ? 0 : 6)) : p;
+    key ^= Zobrist::psq[placed][to];
+
+    if (flag == 2 || flag == 3) {
+        Piece rook = (side == WHITE) ? W_ROOK : B_ROOK;
+        Square rook_from = castle_rook_from[side][flag == 2 ? 0 : 1];
+        Square rook_to = (flag == 2) ? ((side == WHITE) ? SQ_F1 : SQ_F8) : ((side == WHITE) ? SQ_D1 : SQ_D8);
+        key ^= Zobrist::psq[rook][rook_from] ^ Zobrist::psq[rook][rook_to];
+    }
+
+    key ^= castling_key(castling) ^ castling_key(castling_after(from, to, pt));
+    key ^= Zobrist::enpassant[ep_square];
+    key ^= Zobrist::enpassant[flag == 1 ? (Square)((from + to) / 2) : SQ_NONE];
+    return key;
+}
+
+// Pawn keys only change on pawn moves, pawn captures and promotions
+Key Position::pawn_key_after(uint16_t move) const {
+    Square to = (Square)(move & 0x3F);
+    Square from = (Square)((move >> 6) & 0x3F);
+    int flag = (move >> 12);
+    Piece p = board[from];
+
+    Key key = p_key;
+    if (p % 6 == PAWN) {
+        key ^= Zobrist::psq[p][from];
+        if (!(flag & 8)) key ^= Zobrist::psq[p][to];
+    }
+    if (flag == 5) {
+        Square capture_sq = (side == WHITE) ? (to + SOUTH) : (to + NORTH);
+        key ^= Zobrist::psq[board[capture_sq]][capture_sq];
+    } else if ((flag & 4) && board[to] != NO_PIECE && board[to] % 6 == PAWN) {
+        key ^= Zobrist::psq[board[to]][to];
+    }
     return key;
 }
 
@@ -15,6 +15,8 @@ public:
     struct StateInfo {
         Key key;
         Key pawn_key;
+        Key non_pawn_key[COLOR_NB];
+        Key material_key;
         int castling;
         Square castle_rook_from[COLOR_NB][2];
         Square ep_square;
@@ -46,6 +48,8 @@ public:
     Color side_to_move() const { return side; }
     Key key() const { return st_key; }
     Key pawn_key() const { return p_key; }
+    Key non_pawn_key(Color c) const { return np_key[c]; } // Pieces (king included) of colour c
+    Key material_key() const { return m_key; } // Piece counts only
     Square en_passant_square() const { return ep_square; }
     int castling_rights_mask() const { return castling; }
     Square castling_rook_from(Color c, int side) const { return castle_rook_from[c][side]; }
@@ -65,6 +69,11 @@ public:
     void make_move(uint16_t move); // Move is uint16_t encoded
     void unmake_move(uint16_t move);
 
+    // Keys of the position after move, computed without making it (for
+    // prefetching the child's hash entries)
+    Key key_after(uint16_t move) const;
+    Key pawn_key_after(uint16_t move) const;
+
     // Null Move
     void make_null_move();
     void unmake_null_move();
@@ -89,7 +98,8 @@ private:
     void put_piece(Piece p, Square s);
     void remove_piece(Square s);
     void move_piece(Square from, Square to);
-    Key castling_key() const;
+    Key castling_key(int rights) const;
+    int castling_after(Square from, Square to, PieceType pt) const;
 
     // Data
     Bitboard piece_bb[PIECE_TYPE_NB];
@@ -106,6 +116,8 @@ private:
 
     Key st_key;
     Key p_key;
+    Key np_key[COLOR_NB];
+    Key m_key;
     int eval_mg_acc;
     int eval_eg_acc;
     int eval_phase_acc;
@@ -5,6 +5,7 @@
 #include "see.h"
 #include "syzygy.h"
 #include "search_params.h"
+#include "memory.h"
 #include <iostream>
 #include <chrono>
 #include <algorithm>
@@ -12,6 +13,9 @@
 #include <cstring>
 #include <cmath>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <optional>
 
 using namespace std::chrono;
 
@@ -43,10 +47,11 @@ void SearchContext::init_lmr() {
                 quiet_lmr[d][m] = 0;
                 noisy_lmr[d][m] = 0;
             } else {
+                using namespace SearchParams;
                 double ld = std::log(d);
                 double lm = std::log(1.2 * m);
-                quiet_lmr[d][m] = (int)(0.8 + ld * lm / 2.5);
-                noisy_lmr[d][m] = (int)(ld * lm / 3.5);
+                quiet_lmr[d][m] = (int)(LMR_QUIET_BASE / 100.0 + ld * lm / (LMR_QUIET_DIVISOR / 100.0));
+                noisy_lmr[d][m] = (int)(LMR_NOISY_BASE / 100.0 + ld * lm / (LMR_NOISY_DIVISOR / 100.0));
             }
         }
     }
@@ -79,6 +84,15 @@ std::string move_to_uci(uint16_t m) {
     return s;
 }
 
+// UCI score token: "cp <x>" or "mate <n>" in moves
+std::string uci_score(int score) {
+    if (std::abs(score) > 30000) {
+        int mate = (MATE_SCORE - std::abs(score) + 1) / 2;
+        return "mate " + std::to_string(score > 0 ? mate : -mate);
+    }
+    return "cp " + std::to_string(score);
+}
+
 // ----------------------------------------------------------------------------
 // MovePicker
 // ----------------------------------------------------------------------------
@@ -98,7 +112,7 @@ class MovePicker {
     uint16_t tt_move;
     uint16_t prev_move;
     uint16_t killers[2];
-    int ply;
+    const SearchStack* ss;
     int stage;
     bool captures_only;
     bool skip_bad_captures;
@@ -119,18 +133,14 @@ class MovePicker {
     static const int SCORE_BAD_CAPTURE_BASE = -200000;
 
 public:
-    MovePicker(const Position& p, SearchWorker& w, uint16_t tm, int pl, uint16_t pm)
-        : pos(p), worker(w), tt_move(tm), prev_move(pm), ply(pl), stage(STAGE_TT_MOVE), captures_only(false), skip_bad_captures(false), killer_idx(0) {
-        if (ply < MAX_PLY) {
-            killers[0] = worker.KillerMoves[ply][0];
-            killers[1] = worker.KillerMoves[ply][1];
-        } else {
-            killers[0] = killers[1] = 0;
-        }
+    MovePicker(const Position& p, SearchWorker& w, uint16_t tm, const SearchStack* ss)
+        : pos(p), worker(w), tt_move(tm), prev_move((ss - 1)->move), ss(ss), stage(STAGE_TT_MOVE), captures_only(false), skip_bad_captures(false), killer_idx(0) {
+        killers[0] = ss->killers[0];
+        killers[1] = ss->killers[1];
     }
 
     MovePicker(const Position& p, SearchWorker& w, bool caps_only, bool skip_bad = false)
-        : pos(p), worker(w), tt_move(0), prev_move(0), ply(0), stage(STAGE_GOOD_CAPTURES), captures_only(caps_only), skip_bad_captures(skip_bad), killer_idx(0) {
+        : pos(p), worker(w), tt_move(0), prev_move(0), ss(nullptr), stage(STAGE_GOOD_CAPTURES), captures_only(caps_only), skip_bad_captures(skip_bad), killer_idx(0) {
         killers[0] = killers[1] = 0;
     }
 
@@ -207,25 +217,16 @@ public:
     }
 
     void score_quiets() {
-        Square prev_to = SQ_NONE;
-        Piece prev_pc = NO_PIECE;
-        if (prev_move != 0) {
-             prev_to = (Square)(prev_move & 0x3F);
-             prev_pc = pos.piece_on(prev_to);
-        }
-
         for (int i = 0; i < list.count; i++) {
             uint16_t m = list.moves[i];
             Square t = (Square)(m & 0x3F);
             Piece pc = pos.piece_on((Square)((m >> 6) & 0x3F));
-            int pt = pc % 6;
 
             int score = 0;
             if (worker.limits.use_history) {
-                score = worker.History[pos.side_to_move()][pt][t];
-                if (prev_pc != NO_PIECE && prev_to != SQ_NONE) {
-                    score += worker.ContHistory[pos.side_to_move()][prev_pc % 6][prev_to][pt][t];
-                }
+                // Quiescence evasions have no frame to look back from
+                score = ss ? worker.quiet_history(ss, pos.side_to_move(), pc, t)
+                           : worker.History[pos.side_to_move()][pc % 6][t];
                 if (prev_move != 0) {
                     Square pf = (Square)((prev_move >> 6) & 0x3F);
                     Square pt_sq = (Square)(prev_move & 0x3F);
@@ -337,89 +338,93 @@ public:
 SearchWorker::SearchWorker(int id, SearchContext& context)
     : thread_id(id),
       context(&context),
-      node_count(0),
-      exit_thread(false),
-      searching(false),
-    best_move(0), best_score(0), depth_reached(0), pv_length(0) {
+      published_nodes(0),
+      nodes(0),
+    best_move(0), best_score(0), depth_reached(0), tb_root(false),
+      start_latency_us(0) {
     clear_history();
 }
 
 SearchWorker::~SearchWorker() {
     stop();
-    {
-        std::lock_guard<std::mutex> lk(mutex);
-        exit_thread = true;
-    }
-    cv.notify_one();
-    if (worker_thread.joinable()) worker_thread.join();
 }
 
-void SearchWorker::start_search(const Position& pos, const SearchLimits& lm) {
-    {
-        std::lock_guard<std::mutex> lk(mutex);
-        root_pos = pos;
-        limits = lm;
-        searching.store(true, std::memory_order_release);
-    }
-    if (thread_id != 0 && !worker_thread.joinable()) {
-        worker_thread = std::thread(&SearchWorker::search_loop, this);
-    } else if (thread_id != 0) {
-        cv.notify_one();
-    }
+void* SearchWorker::operator new(size_t size) {
+    void* mem = Memory::alloc_large(size);
+    if (!mem) throw std::bad_alloc();
+    return mem;
+}
+
+void SearchWorker::operator delete(void* ptr) {
+    Memory::free_large(ptr);
 }
 
-void SearchWorker::wait_for_completion() {
-    if (thread_id == 0) return;
-    std::unique_lock<std::mutex> lk(mutex);
-    cv.wait(lk, [this] { return !searching.load(std::memory_order_acquire); });
+// Called by the starting thread before the pool generation is bumped; the
+// release store of the new generation publishes these fields to the helper.
+void SearchWorker::start_search(const Position& pos, const SearchLimits& lm) {
+    root_pos = pos;
+    limits = lm;
+    nodes = 0;
+    out_of_nodes = false;
+    start_latency_us = 0; // Stays 0 if the root needs no search (tablebase)
+    publish_nodes();
 }
 
 void SearchWorker::stop() {}
 
 void SearchWorker::search_loop() {
-    if (thread_id == 0) {
-        node_count.store(0, std::memory_order_relaxed);
-        decay_history();
-        iter_deep(*context);
-        searching.store(false, std::memory_order_release);
-        cv.notify_all();
-        return;
+    // The master runs on the caller's thread (UCI reader, bench, datagen
+    // workers): pin it like slot 0 for this search only
+    std::optional<Numa::ScopedBinding> caller_binding;
+    if (thread_id == 0) caller_binding.emplace(0);
+    decay_history();
+    if (epochs) {
+        // Only has to hold one iteration's writes
+        size_t share = TTable.size_mb() / (context->pool->workers.size() + 1);
+        size_t mb = std::clamp<size_t>(share, 1, EPOCH_TT_MAX_MB);
+        if (!epoch_tt || epoch_tt->size_mb() != mb) epoch_tt = std::make_unique<TranspositionTable>(mb);
     }
-    while (true) {
-        std::unique_lock<std::mutex> lk(mutex);
-        cv.wait(lk, [this] { return searching.load(std::memory_order_acquire) || exit_thread; });
-        if (exit_thread) return;
-
-        node_count.store(0, std::memory_order_relaxed);
-        decay_history();
-        lk.unlock();
-
-        iter_deep(*context);
-
-        lk.lock();
-        searching.store(false, std::memory_order_release);
-        cv.notify_all();
+    if (limits.qs_tt != QsTTPolicy::Shared) {
+        size_t mb = (size_t)std::max(limits.qs_hash_mb, 1);
+        if (!qs_tt || qs_tt->size_mb() != mb) qs_tt = std::make_unique<TranspositionTable>(mb);
+        qs_tt->new_search();
+    } else {
+        qs_tt.reset();
     }
+    if (pawn_table.size_mb() != (size_t)std::max(limits.pawn_hash_mb, 1)) pawn_table.resize(limits.pawn_hash_mb);
+    if (material_table.size_mb() == 0) material_table.resize(1);
+    Eval::set_tables(&pawn_table, &material_table);
+    iter_deep(*context);
+    Eval::set_tables(nullptr, nullptr); // The worker may be gone by the next eval on this thread
+    publish_nodes();
+    if (epochs) context->pool->epoch_leave();
 }
 
 void SearchWorker::check_limits(SearchContext& search_context) {
     if (search_context.stop_flag) return;
-    if (search_context.nodes_limit_count > 0
-        && search_context.pool->get_total_nodes() >= search_context.nodes_limit_count) {
-        search_context.stop_flag = true;
-        return;
+    if (node_budget > 0) {
+        // Deterministic mode: stop on this thread's own count only, so the
+        // stop point does not depend on how fast the other threads ran
+        if (nodes >= node_budget) out_of_nodes = true;
+        else if (node_budget - nodes <= NODE_BATCH) node_check_mask = 0;
+    } else if (search_context.nodes_limit_count > 0) {
+        long long remaining = search_context.nodes_limit_count - search_context.pool->get_total_nodes();
+        if (remaining <= 0) {
+            search_context.stop_flag = true;
+            return;
+        }
+        // The published total lags by up to a batch per thread, and each
+        // thread runs up to another batch before its next check: from twice
+        // that distance on, every thread publishes and checks at every node
+        long long threads = (long long)search_context.pool->workers.size() + 1;
+        if (remaining <= 2 * threads * NODE_BATCH) search_context.nodes_near_limit.store(true, std::memory_order_relaxed);
+        if (search_context.nodes_near_limit.load(std::memory_order_relaxed)) node_check_mask = 0;
     }
-    if (search_context.hard_time_limit > 0 || search_context.soft_time_limit > 0) {
+    if (thread_id != 0) return;
+    if (search_context.time.enabled() && !search_context.pondering.load(std::memory_order_relaxed)) {
         auto now = steady_clock::now();
         long long ms = duration_cast<milliseconds>(now - search_context.start_time).count();
-
-        // Zahak: Stop at 2x Soft Limit
-        if (search_context.soft_time_limit > 0 && ms >= 2 * search_context.soft_time_limit) {
-             search_context.stop_flag = true;
-             return;
-        }
-
-        if (search_context.hard_time_limit > 0 && ms >= search_context.hard_time_limit) {
+        if (search_context.time.must_stop(ms, depth_reached > 0)) {
             search_context.stop_flag = true;
             return;
         }
@@ -431,7 +436,25 @@ void SearchWorker::clear_history() {
     std::memset(CaptureHistory, 0, sizeof(CaptureHistory));
     std::memset(ContHistory, 0, sizeof(ContHistory));
     std::memset(CounterMove, 0, sizeof(CounterMove));
-    std::memset(KillerMoves, 0, sizeof(KillerMoves));
+    std::memset(PawnCorrHistory, 0, sizeof(PawnCorrHistory));
+    std::memset(NonPawnCorrHistory, 0, sizeof(NonPawnCorrHistory));
+    std::memset(stack, 0, sizeof(stack));
+    if (qs_tt) qs_tt->clear();
+    pawn_table.clear();
+    material_table.clear();
+}
+
+// Frames below ply 0 stand for moves before the root: no move, no history
+void SearchWorker::reset_stack() {
+    for (int i = 0; i < MAX_PLY + STACK_OFFSET + 1; i++) {
+        SearchStack& f = stack[i];
+        f.move = 0;
+        f.moved_piece = NO_PIECE;
+        f.static_eval = 0;
+        f.cont_hist = nullptr;
+        f.excluded_move = 0;
+        f.reduction = 0;
+    }
 }
 
 void SearchWorker::decay_history() {
@@ -458,10 +481,26 @@ void SearchWorker::update_capture_history(int side, int pt, int to, int captured
     h += bonus - (h * std::abs(bonus)) / MAX_HISTORY;
 }
 
-void SearchWorker::update_continuation(int side, int prev_pt, int prev_to, int pt, int to, int bonus) {
+// Butterfly history plus the continuation rows of the moves 1, 2 and 4
+// plies before the frame ss
+int SearchWorker::quiet_history(const SearchStack* ss, int side, Piece pc, int to) const {
+    int score = History[side][pc % 6][to];
+    for (int back : {1, 2, 4}) {
+        const int16_t (*ch)[64] = (ss - back)->cont_hist;
+        if (ch) score += ch[pc][to];
+    }
+    return score;
+}
+
+// Updates the rows of the moves 1, 2 and 4 plies before the frame ss
+void SearchWorker::update_continuation(const SearchStack* ss, Piece pc, int to, int bonus) {
     if (std::abs(bonus) > 1200) bonus = (bonus > 0) ? 1200 : -1200;
-    int16_t& h = ContHistory[side][prev_pt][prev_to][pt][to];
-    h += bonus - (h * std::abs(bonus)) / MAX_HISTORY;
+    for (int back : {1, 2, 4}) {
+        int16_t (*ch)[64] = (ss - back)->cont_hist;
+        if (!ch) continue;
+        int16_t& h = ch[pc][to];
+        h += bonus - (h * std::abs(bonus)) / MAX_HISTORY;
+    }
 }
 
 void SearchWorker::update_counter_move(int side, int prev_from, int prev_to, uint16_t move) {
@@ -469,14 +508,91 @@ void SearchWorker::update_counter_move(int side, int prev_from, int prev_to, uin
     CounterMove[side][key] = move;
 }
 
+// Gravity updates after a beta cutoff: the cutoff move gets the bonus and
+// every move of the same kind tried before it gets the matching malus.
+// Captures tried before the cutoff are penalised whatever cut.
+void SearchWorker::update_cutoff_histories(SearchStack* ss, const Position& pos, uint16_t best, bool best_quiet, int depth,
+                                           const uint16_t* quiets, int quiet_count, const uint16_t* captures, int capture_count) {
+    int side = pos.side_to_move();
+    int bonus = std::min(depth * depth, 400);
+
+    auto capture_entry = [&](uint16_t m, int b) {
+        Square t = (Square)(m & 0x3F);
+        Piece victim = pos.piece_on(t);
+        int v_pt = ((m >> 12) == 5 || victim == NO_PIECE) ? 0 : victim % 6;
+        update_capture_history(side, pos.piece_on((Square)((m >> 6) & 0x3F)) % 6, t, v_pt, b);
+    };
+
+    if (best_quiet) {
+        if (ss->killers[0] != best) {
+            ss->killers[1] = ss->killers[0];
+            ss->killers[0] = best;
+        }
+        uint16_t prev = (ss - 1)->move;
+        if (prev != 0) update_counter_move(side, (prev >> 6) & 0x3F, prev & 0x3F, best);
+
+        for (int i = -1; i < quiet_count; i++) {
+            uint16_t m = (i < 0) ? best : quiets[i];
+            int b = (i < 0) ? bonus : -bonus;
+            Square t = (Square)(m & 0x3F);
+            Piece pc = pos.piece_on((Square)((m >> 6) & 0x3F));
+            update_history(side, pc % 6, t, b);
+            update_continuation(ss, pc, t, b);
+        }
+    } else {
+        capture_entry(best, bonus);
+    }
+
+    for (int i = 0; i < capture_count; i++) capture_entry(captures[i], -bonus);
+}
+
+int SearchWorker::corrected_eval(const Position& pos, int raw_eval) const {
+    int side = pos.side_to_move();
+    int correction = PawnCorrHistory[side][pos.pawn_key() & (CORR_HISTORY_SIZE - 1)]
+                   + (NonPawnCorrHistory[side][WHITE][pos.non_pawn_key(WHITE) & (CORR_HISTORY_SIZE - 1)]
+                    + NonPawnCorrHistory[side][BLACK][pos.non_pawn_key(BLACK) & (CORR_HISTORY_SIZE - 1)]) / 2;
+    return std::clamp(raw_eval + correction / SearchParams::CORR_HISTORY_GRAIN, -MATE_SCORE + MAX_PLY, MATE_SCORE - MAX_PLY);
+}
+
+// Moves each table entry towards diff (search score minus raw static eval),
+// trusting deeper searches more
+void SearchWorker::update_correction_history(const Position& pos, int depth, int diff) {
+    using namespace SearchParams;
+    int side = pos.side_to_move();
+    int target = std::clamp(diff * CORR_HISTORY_GRAIN, -CORR_HISTORY_MAX, CORR_HISTORY_MAX);
+    int weight = std::min(depth * depth + 2 * depth + 1, 128);
+
+    auto blend = [&](int16_t& entry) {
+        int v = (entry * (CORR_HISTORY_WEIGHT_SCALE - weight) + target * weight) / CORR_HISTORY_WEIGHT_SCALE;
+        entry = (int16_t)std::clamp(v, -CORR_HISTORY_MAX, CORR_HISTORY_MAX);
+    };
+    blend(PawnCorrHistory[side][pos.pawn_key() & (CORR_HISTORY_SIZE - 1)]);
+    blend(NonPawnCorrHistory[side][WHITE][pos.non_pawn_key(WHITE) & (CORR_HISTORY_SIZE - 1)]);
+    blend(NonPawnCorrHistory[side][BLACK][pos.non_pawn_key(BLACK) & (CORR_HISTORY_SIZE - 1)]);
+}
+
+// Triangular PV: row ply holds the line from ply onward; the child's row is
+// copied behind the move that raised alpha.
+void SearchWorker::update_pv(int ply, uint16_t move) {
+    pv_table[ply][ply] = move;
+    int child_len = pv_len[ply + 1];
+    for (int i = ply + 1; i < child_len; i++) pv_table[ply][i] = pv_table[ply + 1][i];
+    pv_len[ply] = std::max(child_len, ply + 1);
+}
+
 // ----------------------------------------------------------------------------
 // Search Algorithms
 // ----------------------------------------------------------------------------
 
 int SearchWorker::quiescence(SearchContext& search_context, Position& pos, int alpha, int beta, int ply) {
-    if ((node_count.load(std::memory_order_relaxed) & 1023) == 0 && thread_id == 0) check_limits(search_context);
-    if (search_context.stop_flag) return 0;
-    node_count.fetch_add(1, std::memory_order_relaxed);
+    pv_len[ply] = ply; // No PV below the horizon
+    if ((nodes & node_check_mask) == 0) {
+        publish_nodes();
+        if (thread_id == 0 || node_budget > 0 || search_context.nodes_limit_count > 0) check_limits(search_context);
+    }
+    if (stopped(search_context)) return 0;
+    nodes++;
+    STAT_INC(qs_nodes);
 
     if (ply >= MAX_PLY - 1) return Eval::evaluate(pos);
     if (ply > 0 && (pos.rule50_count() >= 100 || pos.is_repetition())) return 0;
@@ -485,17 +601,23 @@ int SearchWorker::quiescence(SearchContext& search_context, Position& pos, int a
     uint16_t best_move = 0;
 
     // TT Probe
-    TTEntry tte;
-    bool tt_hit = TTable.probe(pos.key(), tte);
+    TTEntry tte{};
+    bool tt_hit = qs_probe(pos.key(), tte);
     if (tt_hit && tte.depth >= 0) {
         int tt_score = score_from_tt(tte.score, ply);
-        if (tte.bound() == 1) return tt_score; // Exact
+        if (tte.bound() == 1) { // Exact
+            STAT_INC(qs_tt_cutoffs);
+            return tt_score;
+        }
         if (tte.bound() == 2) { // Upper
             if (tt_score < beta) beta = tt_score;
         } else if (tte.bound() == 3) { // Lower
             if (tt_score > alpha) alpha = tt_score;
         }
-        if (alpha >= beta) return alpha;
+        if (alpha >= beta) {
+            STAT_INC(qs_tt_cutoffs);
+            return alpha;
+        }
     }
 
     bool in_check = pos.in_check();
@@ -506,7 +628,7 @@ int SearchWorker::quiescence(SearchContext& search_context, Position& pos, int a
         stand_pat = Eval::evaluate_light(pos);
         static_eval = stand_pat;
         if (stand_pat >= beta) {
-            TTable.store(pos.key(), 0, score_to_tt(stand_pat, ply), static_eval, 0, 3);
+            qs_store(pos.key(), 0, score_to_tt(stand_pat, ply), static_eval, 3, true);
             return beta;
         }
 
@@ -541,19 +663,19 @@ int SearchWorker::quiescence(SearchContext& search_context, Position& pos, int a
              if (see_val < 0) continue;
         }
 
+        TTable.prefetch(pos.key_after(move));
         pos.make_move(move);
         if (pos.is_attacked((Square)Bitboards::lsb(pos.pieces(KING, ~pos.side_to_move())), pos.side_to_move())) {
             pos.unmake_move(move);
             continue;
         }
         moves_searched++;
-        TTable.prefetch(pos.key());
         int score = -quiescence(search_context, pos, -beta, -alpha, ply + 1);
         pos.unmake_move(move);
-        if (search_context.stop_flag) return 0;
+        if (stopped(search_context)) return 0;
 
         if (score >= beta) {
-            TTable.store(pos.key(), move, score_to_tt(score, ply), static_eval, 0, 3);
+            qs_store(pos.key(), move, score_to_tt(score, ply), static_eval, 3, false);
             return beta;
         }
         if (score > alpha) {
@@ -564,23 +686,28 @@ int SearchWorker::quiescence(SearchContext& search_context, Position& pos, int a
 
     if (in_check && moves_searched == 0) {
         int mate_score = -MATE_SCORE + ply;
-        TTable.store(pos.key(), 0, score_to_tt(mate_score, ply), static_eval, 0, 1);
+        qs_store(pos.key(), 0, score_to_tt(mate_score, ply), static_eval, 1, false);
         return mate_score;
     }
 
     int bound = (alpha > original_alpha) ? 1 : 2; // 1=Exact, 2=Upper
-    TTable.store(pos.key(), best_move, score_to_tt(alpha, ply), static_eval, 0, bound);
+    qs_store(pos.key(), best_move, score_to_tt(alpha, ply), static_eval, bound, false);
     return alpha;
 }
 
-int SearchWorker::negamax(SearchContext& search_context, Position& pos, int depth, int alpha, int beta, int ply, bool null_allowed, uint16_t prev_move, uint16_t excluded_move) {
-    if ((node_count.load(std::memory_order_relaxed) & 1023) == 0 && thread_id == 0) check_limits(search_context);
-    if (thread_id != 0 && (node_count.load(std::memory_order_relaxed) & 1023) == 0 && search_context.stop_flag) {
-        return 0;
+// Moves remembered per node for history maluses
+constexpr int MAX_TRIED = 64;
+
+int SearchWorker::negamax(SearchContext& search_context, Position& pos, int depth, int alpha, int beta, int ply, bool null_allowed) {
+    pv_len[ply] = ply;
+    if ((nodes & node_check_mask) == 0) {
+        publish_nodes();
+        if (thread_id == 0 || node_budget > 0 || search_context.nodes_limit_count > 0) check_limits(search_context);
     }
-    if (search_context.stop_flag) return 0;
+    if (stopped(search_context)) return 0;
 
-    node_count.fetch_add(1, std::memory_order_relaxed);
+    nodes++;
+    STAT_INC(nodes);
     int original_alpha = alpha;
 
     // Mate Distance Pruning
@@ -593,6 +720,10 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
     // Draw Detection
     if (ply > 0 && (pos.rule50_count() >= 100 || pos.is_repetition())) return 0;
 
+    SearchStack* ss = frame(ply);
+    uint16_t excluded_move = ss->excluded_move;
+    (ss + 1)->excluded_move = 0;
+
     bool is_pv = (beta - alpha > 1);
     bool in_check = pos.in_check();
 
@@ -623,17 +754,30 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
     }
 
     // TT Probe
-    TTEntry tte;
+    TTEntry tte{};
     uint16_t tt_move = 0;
-    bool tt_hit = TTable.probe(pos.key(), tte);
+    bool tt_hit = tt_probe(pos.key(), tte);
+    if (depth >= 4) {
+        STAT_INC(tt_deep_probes);
+        if (tt_hit) STAT_INC(tt_deep_hits);
+    }
 
     if (tt_hit) {
         tt_move = tte.move;
         int tt_score = score_from_tt(tte.score, ply);
         if (!is_pv && tte.depth >= depth && excluded_move == 0) {
-            if (tte.bound() == 1) return tt_score; // Exact
-            if (tte.bound() == 2 && tt_score <= alpha) return alpha; // Upper
-            if (tte.bound() == 3 && tt_score >= beta) return tt_score; // Lower
+            if (tte.bound() == 1) { // Exact
+                STAT_INC(tt_cutoffs);
+                return tt_score;
+            }
+            if (tte.bound() == 2 && tt_score <= alpha) { // Upper
+                STAT_INC(tt_cutoffs);
+                return alpha;
+            }
+            if (tte.bound() == 3 && tt_score >= beta) { // Lower
+                STAT_INC(tt_cutoffs);
+                return tt_score;
+            }
         }
     }
 
@@ -642,10 +786,11 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
         depth -= 1;
     }
 
-    int static_eval = Eval::evaluate(pos);
-    static_evals[ply] = static_eval;
-    bool improving = (ply > 2 && static_evals[ply] > static_evals[ply - 2]);
-    if (prev_move == 0) improving = true; // Root or Null Move recovery?
+    int raw_eval = Eval::evaluate(pos);
+    int static_eval = corrected_eval(pos, raw_eval);
+    ss->static_eval = static_eval;
+    bool improving = (ply > 2 && ss->static_eval > (ss - 2)->static_eval);
+    if ((ss - 1)->move == 0) improving = true; // Root or Null Move recovery?
 
     // Threat Pruning (Zahak)
     if (!is_pv && !in_check && depth == 1 && static_eval > beta + SearchParams::TP_MARGIN &&
@@ -667,15 +812,22 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
              return beta;
         }
 
-        int score = negamax(search_context, pos, (depth - 1) / 2, singular_beta - 1, singular_beta, ply, false, prev_move, tt_move);
+        ss->excluded_move = tt_move;
+        int score = negamax(search_context, pos, (depth - 1) / 2, singular_beta - 1, singular_beta, ply, false);
 
         if (score < singular_beta) {
              singular_ext = 1;
+             STAT_INC(singular_extensions);
         } else if (score >= beta) {
             // Multi-Cut: if score >= beta, research with beta
-             score = negamax(search_context, pos, (depth + 3) / 2, beta - 1, beta, ply, false, prev_move, tt_move);
-             if (score >= beta) return beta;
+             score = negamax(search_context, pos, (depth + 3) / 2, beta - 1, beta, ply, false);
+             if (score >= beta) {
+                 STAT_INC(multicut_cutoffs);
+                 ss->excluded_move = 0;
+                 return beta;
+             }
         }
+        ss->excluded_move = 0;
     }
 
     // Pruning (Non-PV)
@@ -685,43 +837,93 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
         int rfp_margin = SearchParams::RFP_MARGIN * depth;
         // Logic for improving needs to be robust.
         // For now, standard RFP
-        if (depth <= 8 && static_eval - rfp_margin >= beta) return static_eval - rfp_margin; // Fail soft
+        if (depth <= 8 && static_eval - rfp_margin >= beta) { // Fail soft
+            STAT_INC(rfp_cutoffs);
+            return static_eval - rfp_margin;
+        }
 
         // Null Move Pruning
         if (limits.use_nmp && null_allowed && depth >= SearchParams::NMP_DEPTH_LIMIT && static_eval > beta && pos.non_pawn_material(pos.side_to_move()) >= 300) {
             // Zahak: R = 4 + min(depth/4, 3). If eval >= beta+100 R+=1.
-            int R = 4 + std::min(depth / 4, 3);
-            if (static_eval >= beta + 100) R += 1;
+            int R = SearchParams::NMP_BASE_REDUCTION + std::min(depth / SearchParams::NMP_DIVISOR, 3);
+            if (static_eval >= beta + SearchParams::NMP_EVAL_MARGIN) R += 1;
             R = std::min(R, depth);
 
+            ss->move = 0;
+            ss->moved_piece = NO_PIECE;
+            ss->cont_hist = nullptr;
+            STAT_INC(nmp_tries);
             pos.make_null_move();
-            int score = -negamax(search_context, pos, depth - R, -beta, -beta + 1, ply + 1, false, 0, 0);
+            int score = -negamax(search_context, pos, depth - R, -beta, -beta + 1, ply + 1, false);
             pos.unmake_null_move();
-            if (search_context.stop_flag) return 0;
+            if (stopped(search_context)) return 0;
             if (score >= beta) {
+                STAT_INC(nmp_cutoffs);
                 return beta;
             }
         }
     }
 
+    // ProbCut: a capture that beats beta by a margin in a reduced search
+    // very likely beats beta at full depth too
+    int probcut_beta = beta + SearchParams::PROBCUT_MARGIN;
+    if (limits.use_probcut && !is_pv && !in_check && depth >= SearchParams::PROBCUT_DEPTH && excluded_move == 0 &&
+        std::abs(beta) < MATE_SCORE - MAX_PLY &&
+        !(tt_hit && tte.depth >= depth - 3 && score_from_tt(tte.score, ply) < probcut_beta)) {
+        MovePicker pc_mp(pos, *this, true, true);
+        uint16_t move;
+        while ((move = pc_mp.next())) {
+            if (see(pos, move) < probcut_beta - static_eval) continue;
+
+            Square t = (Square)(move & 0x3F);
+            ss->move = move;
+            ss->moved_piece = pos.piece_on((Square)((move >> 6) & 0x3F));
+            ss->cont_hist = ContHistory[ss->moved_piece][t];
+
+            TTable.prefetch(pos.key_after(move));
+            pos.make_move(move);
+            if (pos.is_attacked((Square)Bitboards::lsb(pos.pieces(KING, ~pos.side_to_move())), pos.side_to_move())) {
+                pos.unmake_move(move);
+                continue;
+            }
+
+            // Cheap qsearch filter before the reduced verification search
+            int score = -quiescence(search_context, pos, -probcut_beta, -probcut_beta + 1, ply + 1);
+            if (score >= probcut_beta) {
+                STAT_INC(probcut_tries);
+                score = -negamax(search_context, pos, depth - SearchParams::PROBCUT_REDUCTION, -probcut_beta, -probcut_beta + 1, ply + 1, true);
+            }
+            pos.unmake_move(move);
+            if (stopped(search_context)) return 0;
+
+            if (score >= probcut_beta) {
+                STAT_INC(probcut_cutoffs);
+                tt_store(pos.key(), move, score_to_tt(score, ply), raw_eval, depth - SearchParams::PROBCUT_REDUCTION + 1, 3);
+                return score;
+            }
+        }
+    }
+
     // Razoring (depth <= 2)
     if (!is_pv && !in_check && depth <= 2 && static_eval + SearchParams::RAZORING_MARGIN <= alpha) {
+            STAT_INC(razor_returns);
             int qscore = quiescence(search_context, pos, alpha, beta, ply);
             return qscore; // Zahak returns qscore, not alpha check
     }
 
 
-    MovePicker mp(pos, *this, tt_move, ply, prev_move);
+    MovePicker mp(pos, *this, tt_move, ss);
     uint16_t move;
+    uint16_t quiets_tried[MAX_TRIED];
+    uint16_t captures_tried[MAX_TRIED];
+    int quiet_count = 0;
+    int capture_count = 0;
     int moves_searched = 0;
     int best_score = -INFINITY_SCORE;
     uint16_t best_move = 0;
-    Square prev_to = SQ_NONE;
-    Piece prev_pc = NO_PIECE;
-    if (prev_move != 0) {
-        prev_to = (Square)(prev_move & 0x3F);
-        prev_pc = pos.piece_on(prev_to);
-    }
+
+    // Singular/null-move searches above may have written this ply's PV row
+    pv_len[ply] = ply;
 
     // PV Search Loop
     while ((move = mp.next())) {
@@ -730,18 +932,24 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
 
         bool is_cap = ((move >> 12) & 4) || ((move >> 12) == 5) || ((move >> 12) & 8);
         bool is_quiet = !is_cap;
-        bool is_killer = (move == KillerMoves[ply][0] || move == KillerMoves[ply][1]);
+        bool is_killer = (move == ss->killers[0] || move == ss->killers[1]);
 
         // Late Move Pruning (Quiet only)
         if (!is_pv && !in_check && is_quiet) {
             int lmp_threshold = (3 + depth * depth) / (2 - (depth > 5));
-            if (moves_searched > lmp_threshold) break;
+            if (moves_searched > lmp_threshold) {
+                STAT_INC(lmp_prunes);
+                break;
+            }
         }
 
         // Futility Pruning (Quiet only)
         if (!is_pv && !in_check && is_quiet && depth < 5 && moves_searched > 0) {
              int fmargin = SearchParams::FUTILITY_MARGIN * depth;
-             if (static_eval + fmargin <= alpha) break; // Prune remaining quiets
+             if (static_eval + fmargin <= alpha) { // Prune remaining quiets
+                 STAT_INC(futility_prunes);
+                 break;
+             }
         }
 
         Square f = (Square)((move >> 6) & 0x3F);
@@ -751,13 +959,11 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
         int pt = pc % 6;
         int history_score = 0;
         if (is_quiet && limits.use_history) {
-            history_score = History[side][pt][t];
-            if (prev_pc != NO_PIECE && prev_to != SQ_NONE) {
-                history_score += ContHistory[side][prev_pc % 6][prev_to][pt][t];
-            }
+            history_score = quiet_history(ss, side, pc, t);
         }
         if (!is_pv && !in_check && is_quiet && depth <= SearchParams::HISTORY_PRUNE_DEPTH && limits.use_history) {
             if (history_score < SearchParams::HISTORY_PRUNE_THRESHOLD) {
+                STAT_INC(history_prunes);
                 continue;
             }
         }
@@ -767,6 +973,13 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
             history_norm = static_cast<double>(history_clamped) / MAX_HISTORY;
         }
 
+        ss->move = move;
+        ss->moved_piece = pc;
+        ss->cont_hist = ContHistory[pc][t];
+
+        // The child probes both right after make_move; start the loads now
+        TTable.prefetch(pos.key_after(move));
+        Eval::prefetch_pawns(pos.pawn_key_after(move));
         pos.make_move(move);
         if (pos.is_attacked((Square)Bitboards::lsb(pos.pieces(KING, ~pos.side_to_move())), pos.side_to_move())) {
             pos.unmake_move(move);
@@ -778,7 +991,7 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
 
         int score;
         if (moves_searched == 1) {
-            score = -negamax(search_context, pos, depth - 1 + singular_ext, -beta, -alpha, ply + 1, true, move, 0);
+            score = -negamax(search_context, pos, depth - 1 + singular_ext, -beta, -alpha, ply + 1, true);
         } else {
             // LMR
             int reduction = 0;
@@ -805,18 +1018,23 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
                 reduction = std::clamp(reduction, 0, max_reduction);
             }
 
-            score = -negamax(search_context, pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, true, move, 0);
+            ss->reduction = reduction;
+            score = -negamax(search_context, pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, true);
+            ss->reduction = 0;
 
+            if (reduction > 0) STAT_INC(lmr_searches);
             if (score > alpha && reduction > 0) {
-                 score = -negamax(search_context, pos, depth - 1 + singular_ext, -alpha - 1, -alpha, ply + 1, true, move, 0);
+                 STAT_INC(lmr_researches);
+                 score = -negamax(search_context, pos, depth - 1 + singular_ext, -alpha - 1, -alpha, ply + 1, true);
             }
             if (score > alpha && score < beta) {
-                 score = -negamax(search_context, pos, depth - 1 + singular_ext, -beta, -alpha, ply + 1, true, move, 0);
+                 STAT_INC(pvs_researches);
+                 score = -negamax(search_context, pos, depth - 1 + singular_ext, -beta, -alpha, ply + 1, true);
             }
         }
 
         pos.unmake_move(move);
-        if (search_context.stop_flag) return 0;
+        if (stopped(search_context)) return 0;
 
         if (score > best_score) {
             best_score = score;
@@ -825,22 +1043,21 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
 
         if (score > alpha) {
             alpha = score;
+            if (is_pv) update_pv(ply, move);
             if (score >= beta) { // Cutoff
-                if (is_quiet) {
-                    KillerMoves[ply][1] = KillerMoves[ply][0];
-                    KillerMoves[ply][0] = move;
-                    int bonus = depth * depth;
-                    if (bonus > 400) bonus = 400;
-                    Square f = (Square)((move >> 6) & 0x3F);
-                    Square t = (Square)(move & 0x3F);
-                    Piece pc = pos.piece_on(f);
-                    int pt = pc % 6;
-                    update_history(pos.side_to_move(), pt, t, bonus);
-                    // update counter, cont...
-                }
+                STAT_INC(beta_cutoffs);
+                if (moves_searched == 1) STAT_INC(first_move_cutoffs);
+                update_cutoff_histories(ss, pos, move, is_quiet, depth, quiets_tried, quiet_count, captures_tried, capture_count);
                 break;
             }
         }
+
+        // Moves that failed to cut are penalised if a later move does
+        if (is_quiet) {
+            if (quiet_count < MAX_TRIED) quiets_tried[quiet_count++] = move;
+        } else if (capture_count < MAX_TRIED) {
+            captures_tried[capture_count++] = move;
+        }
     }
 
     if (moves_searched == 0) {
@@ -849,7 +1066,14 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
     }
 
     int bound = (best_score >= beta) ? 3 : ((best_score > original_alpha) ? 1 : 2); // 3=Lower, 1=Exact, 2=Upper
-    TTable.store(pos.key(), best_move, score_to_tt(best_score, ply), static_eval, depth, bound);
+    tt_store(pos.key(), best_move, score_to_tt(best_score, ply), raw_eval, depth, bound);
+
+    // Learn from quiet positions where the bound says which way the eval was wrong
+    bool best_is_capture = best_move && (((best_move >> 12) & 4) || ((best_move >> 12) & 8));
+    if (!in_check && !best_is_capture && excluded_move == 0 && std::abs(best_score) < MATE_SCORE - MAX_PLY &&
+        !(bound == 3 && best_score <= static_eval) && !(bound == 2 && best_score >= static_eval)) {
+        update_correction_history(pos, depth, best_score - raw_eval);
+    }
 
     return best_score;
 }
@@ -858,85 +1082,47 @@ int SearchWorker::negamax(SearchContext& search_context, Position& pos, int dept
 // Iterative Deepening
 // ----------------------------------------------------------------------------
 
-// Helper to retrieve PV from TT
-std::string get_pv(Position& pos, uint16_t root_move) {
-    std::string res = "";
-    std::vector<uint16_t> moves;
-    std::vector<uint64_t> hashes;
-
-    uint16_t m = root_move;
-    int limit = 0;
-
-    while (limit < 64 && m != 0) {
-        if (!MoveGen::is_pseudo_legal(pos, m)) break;
-
-        pos.make_move(m);
-        // Verify legality
-        if (pos.is_attacked((Square)Bitboards::lsb(pos.pieces(KING, ~pos.side_to_move())), pos.side_to_move())) {
-            pos.unmake_move(m);
-            break;
-        }
-
-        // Cycle check
-        bool cycle = false;
-        for (auto h : hashes) if (h == pos.key()) cycle = true;
-        if (cycle) {
-            pos.unmake_move(m);
-            break;
-        }
-
-        hashes.push_back(pos.key());
-        moves.push_back(m);
-        res += move_to_uci(m) + " ";
-        limit++;
-
-        TTEntry tte;
-        if (TTable.probe(pos.key(), tte)) {
-            m = tte.move;
-        } else {
-            m = 0;
-        }
-    }
-
-    // Unmake
-    while (!moves.empty()) {
-        pos.unmake_move(moves.back());
-        moves.pop_back();
+std::string pv_to_uci(const std::vector<uint16_t>& pv) {
+    std::string res;
+    for (uint16_t m : pv) {
+        if (!res.empty()) res += ' ';
+        res += move_to_uci(m);
     }
-
-    if (!res.empty()) res.pop_back();
     return res;
 }
 
-int pv_length_from_move(Position& pos, uint16_t root_move) {
-    if (root_move == 0) {
-        return 0;
-    }
-    std::string pv = get_pv(pos, root_move);
-    if (pv.empty()) {
-        return 0;
-    }
-    return 1 + static_cast<int>(std::count(pv.begin(), pv.end(), ' '));
-}
-
 struct RootMove {
     uint16_t move;
     int score;
     int prev_score;
+    std::vector<uint16_t> pv;
+    long long nodes; // Searched below this move in the current iteration
 };
 
+// Lazy SMP depth staggering: helper i skips depths according to its row so
+// that the pool spreads over neighbouring depths instead of duplicating work.
+static const int SkipSize[]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int SkipPhase[] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+static bool skip_depth(int thread_id, int depth) {
+    if (thread_id == 0) return false;
+    int row = (thread_id - 1) % 20;
+    return ((depth + SkipPhase[row]) / SkipSize[row]) % 2 != 0;
+}
+
 void SearchWorker::iter_deep(SearchContext& search_context) {
     Position& pos = root_pos;
-    if (thread_id == 0) {
-        this->best_move = 0;
-        best_score = 0;
-        depth_reached = 0;
-        pv_length = 0;
-        search_context.unstable_iteration.store(false, std::memory_order_relaxed);
-    }
-
-    // Syzygy Root Probe (Master Only)
-    if (thread_id == 0 && Syzygy::enabled()) {
+    node_check_mask = NODE_BATCH - 1;
+    this->best_move = 0;
+    best_score = 0;
+    depth_reached = 0;
+    pv.clear();
+    tb_root = false;
+    root_scores.clear();
+    reset_stack();
+
+    // Syzygy Root Probe (Master Only); its move may lie outside searchmoves
+    if (thread_id == 0 && Syzygy::enabled() && limits.search_moves.empty()) {
         uint16_t tb_move = 0;
         int tb_score = 0;
         if (Syzygy::probe_root(pos, tb_move, tb_score)) {
@@ -950,11 +1136,11 @@ void SearchWorker::iter_deep(SearchContext& search_context) {
              this->best_move = tb_move;
              best_score = tb_score;
              depth_reached = 1;
-             pv_length = pv_length_from_move(pos, tb_move);
+             pv.assign(1, tb_move);
+             tb_root = true;
 
              if (!limits.silent) {
-                 std::cout << "info depth 1 score " << score_str << " nodes 0 time 0 pv " << get_pv(pos, tb_move) << std::endl;
-                 std::cout << "bestmove " << move_to_uci(tb_move) << std::endl;
+                 std::cout << "info depth 1 score " << score_str << " nodes 0 time 0 pv " << pv_to_uci(pv) << std::endl;
              }
              return;
         }
@@ -970,8 +1156,10 @@ void SearchWorker::iter_deep(SearchContext& search_context) {
             pos.make_move(m);
             bool legal = !pos.is_attacked((Square)Bitboards::lsb(pos.pieces(KING, ~pos.side_to_move())), pos.side_to_move());
             pos.unmake_move(m);
-            if (legal) {
-                root_moves.push_back({m, -INFINITY_SCORE, -INFINITY_SCORE});
+            bool allowed = limits.search_moves.empty()
+                || std::find(limits.search_moves.begin(), limits.search_moves.end(), m) != limits.search_moves.end();
+            if (legal && allowed) {
+                root_moves.push_back({m, -INFINITY_SCORE, -INFINITY_SCORE, {}, 0});
             }
         }
     }
@@ -981,159 +1169,183 @@ void SearchWorker::iter_deep(SearchContext& search_context) {
         return;
     }
 
+    // A legal move to play even if the first iteration is cut short (tiny
+    // go nodes / movetime); it carries no depth, so it never outvotes a search
+    this->best_move = root_moves[0].move;
+    pv.assign(1, root_moves[0].move);
+
+    // Per-search setup (tables, root moves) is done; the first node follows
+    start_latency_us = duration_cast<microseconds>(steady_clock::now() - search_context.start_time).count();
+
     // 2. Iterative Loop
     int max_depth = limits.depth > 0 ? limits.depth : MAX_PLY;
+    // Helpers only feed the TT; exact scores for extra lines are master work
+    int pv_lines = (thread_id == 0) ? std::clamp(limits.multi_pv, 1, (int)root_moves.size()) : 1;
     int best_val = -INFINITY_SCORE;
     uint16_t best_move = 0;
-    uint16_t prev_best_move = 0;
-    int prev_best_score = 0;
-    bool have_prev = false;
 
     for (int depth = 1; depth <= max_depth; depth++) {
-        if (search_context.stop_flag) break;
-
-        // Zahak: CanStartNewIteration (0.7 * SoftLimit)
-        if (search_context.soft_time_limit > 0) {
-             auto now = steady_clock::now();
-             long long ms = duration_cast<milliseconds>(now - search_context.start_time).count();
-             if (ms > 0.7 * search_context.soft_time_limit) break;
+        if (stopped(search_context)) break;
+        // Deterministic mode: start depth only once every thread is done with
+        // its previous iteration and their TT writes have been merged
+        if (epochs && depth > 1) search_context.pool->epoch_sync();
+        if (depth > 1 && depth < max_depth && skip_depth(thread_id, depth)) continue;
+
+        if (thread_id == 0 && !search_context.pondering.load(std::memory_order_relaxed)) {
+             long long ms = duration_cast<milliseconds>(steady_clock::now() - search_context.start_time).count();
+             if (!search_context.time.can_start_iteration(ms)) break;
         }
 
         // Sorting
         std::stable_sort(root_moves.begin(), root_moves.end(), [](const RootMove& a, const RootMove& b) {
             return a.score > b.score;
         });
+        for (auto& rm : root_moves) rm.nodes = 0;
+
+        // MultiPV: line k searches root_moves[k..] after the k best moves of
+        // this iteration have been moved to the front, so each of the first
+        // pv_lines moves gets an exact score from its own aspiration window.
+        for (int pv_idx = 0; pv_idx < pv_lines; pv_idx++) {
+            int alpha = -INFINITY_SCORE;
+            int beta = INFINITY_SCORE;
+
+            // Aspiration Windows
+            int delta = SearchParams::ASPIRATION_DELTA;
+            if (depth >= 5) {
+                int center = (pv_idx == 0) ? best_val : root_moves[pv_idx].score;
+                alpha = std::max(-INFINITY_SCORE, center - delta);
+                beta = std::min(INFINITY_SCORE, center + delta);
+            }
 
-        int alpha = -INFINITY_SCORE;
-        int beta = INFINITY_SCORE;
-
-        // Aspiration Windows
-        int delta = 20;
-        if (depth >= 5) {
-            alpha = std::max(-INFINITY_SCORE, best_val - delta);
-            beta = std::min(INFINITY_SCORE, best_val + delta);
-        }
-
-        while (true) {
-            if (search_context.stop_flag) break;
-
-            int score_max = -INFINITY_SCORE;
-            int best_move_idx = -1;
-
-            for (size_t i = 0; i < root_moves.size(); i++) {
-                 // Smp distribution
-                 if (thread_id != 0 && ((int)i % OptThreads != thread_id)) continue;
-
-                 uint16_t m = root_moves[i].move;
-                 pos.make_move(m);
-
-                 int score;
-                 if (i == 0 && thread_id == 0) {
-                     score = -negamax(search_context, pos, depth - 1, -beta, -alpha, 1, true, m);
-                 } else {
-                     score = -negamax(search_context, pos, depth - 1, -alpha - 1, -alpha, 1, true, m);
-                     if (score > alpha && score < beta) {
-                         score = -negamax(search_context, pos, depth - 1, -beta, -alpha, 1, true, m);
+            while (true) {
+                if (stopped(search_context)) break;
+
+                int score_max = -INFINITY_SCORE;
+                int best_move_idx = -1;
+                int window_alpha = alpha; // alpha is raised inside the loop
+
+                for (size_t i = pv_idx; i < root_moves.size(); i++) {
+                     uint16_t m = root_moves[i].move;
+                     SearchStack* root_ss = frame(0);
+                     root_ss->move = m;
+                     root_ss->moved_piece = pos.piece_on((Square)((m >> 6) & 0x3F));
+                     root_ss->cont_hist = ContHistory[root_ss->moved_piece][m & 0x3F];
+                     long long nodes_before = nodes;
+                     pos.make_move(m);
+
+                     int score;
+                     if (i == (size_t)pv_idx) {
+                         score = -negamax(search_context, pos, depth - 1, -beta, -alpha, 1, true);
+                     } else {
+                         score = -negamax(search_context, pos, depth - 1, -alpha - 1, -alpha, 1, true);
+                         if (score > alpha && score < beta) {
+                             score = -negamax(search_context, pos, depth - 1, -beta, -alpha, 1, true);
+                         }
                      }
-                 }
 
-                 pos.unmake_move(m);
-                 if (search_context.stop_flag) break;
+                     pos.unmake_move(m);
+                     root_moves[i].nodes += nodes - nodes_before;
+                     if (stopped(search_context)) break;
 
-                 root_moves[i].score = score;
-                 if (score > score_max) {
-                     score_max = score;
-                     best_move_idx = i;
-                 }
+                     if (i == (size_t)pv_idx || score > alpha) {
+                         auto& line = root_moves[i].pv;
+                         line.assign(1, m);
+                         line.insert(line.end(), &pv_table[1][1], &pv_table[1][pv_len[1]]);
+                     }
+                     root_moves[i].score = score;
+                     if (score > score_max) {
+                         score_max = score;
+                         best_move_idx = i;
+                     }
 
-                 if (score > alpha) alpha = score;
-                 if (score >= beta) break;
-            }
+                     if (score > alpha) alpha = score;
+                     if (score >= beta) break;
+                }
 
-            if (search_context.stop_flag) break;
+                if (stopped(search_context)) break;
 
-            // Check Aspiration Bounds (Master only usually, but let's sync)
-            if (thread_id == 0) {
-                if (score_max <= alpha && delta < 2000) {
-                    beta = (alpha + beta) / 2;
-                    alpha = std::max(-INFINITY_SCORE, alpha - delta);
+                // Check Aspiration Bounds
+                if (score_max <= window_alpha && delta < 2000) {
+                    beta = (window_alpha + beta) / 2;
+                    alpha = std::max(-INFINITY_SCORE, window_alpha - delta);
                     delta *= 1.5;
                     continue;
                 }
                 if (score_max >= beta && delta < 2000) {
-                    alpha = (alpha + beta) / 2;
+                    alpha = (window_alpha + beta) / 2;
                     beta = std::min(INFINITY_SCORE, beta + delta);
                     delta *= 1.5;
                     continue;
                 }
-                best_val = score_max;
-                if (best_move_idx != -1) best_move = root_moves[best_move_idx].move;
+                if (pv_idx == 0) {
+                    best_val = score_max;
+                    if (best_move_idx != -1) best_move = root_moves[best_move_idx].move;
+                }
+                break;
             }
-            break;
+
+            if (stopped(search_context)) break;
+
+            // Bring this line's best move to pv_idx for the next line
+            std::stable_sort(root_moves.begin() + pv_idx, root_moves.end(), [](const RootMove& a, const RootMove& b) {
+                return a.score > b.score;
+            });
         }
 
-        if (search_context.stop_flag) break;
+        if (stopped(search_context)) break;
+
+        // Every thread keeps its own completed-iteration result for voting
+        root_scores.clear();
+        root_scores.reserve(root_moves.size());
+        for (const auto& rm : root_moves) {
+            root_scores.push_back({rm.move, rm.score});
+        }
+        std::stable_sort(root_scores.begin(), root_scores.end(),
+            [](const SearchResult::RootScore& a, const SearchResult::RootScore& b) {
+                if (a.score != b.score) {
+                    return a.score > b.score;
+                }
+                return a.move < b.move;
+            });
+        this->best_move = best_move;
+        best_score = best_val;
+        depth_reached = depth;
+        for (const auto& rm : root_moves) {
+            if (rm.move == best_move) { pv = rm.pv; break; }
+        }
 
         // Output Info (Master)
         if (thread_id == 0) {
-             root_scores.clear();
-             root_scores.reserve(root_moves.size());
-             for (const auto& rm : root_moves) {
-                 root_scores.push_back({rm.move, rm.score});
-             }
-             std::stable_sort(root_scores.begin(), root_scores.end(),
-                 [](const SearchResult::RootScore& a, const SearchResult::RootScore& b) {
-                     if (a.score != b.score) {
-                         return a.score > b.score;
-                     }
-                     return a.move < b.move;
-                 });
-
+             publish_nodes();
              auto now = steady_clock::now();
              long long ms = duration_cast<milliseconds>(now - search_context.start_time).count();
              long long us = duration_cast<microseconds>(now - search_context.start_time).count();
              long long nps = (us > 0) ? (search_context.pool->get_total_nodes() * 1000000LL / us) : 0;
 
-             std::string score_str = "cp " + std::to_string(best_val);
-             if (std::abs(best_val) > 30000) {
-                 int mate = (MATE_SCORE - std::abs(best_val) + 1) / 2;
-                 score_str = "mate " + std::to_string(best_val > 0 ? mate : -mate);
-             }
-
-             this->best_move = best_move;
-             best_score = best_val;
-             depth_reached = depth;
-             pv_length = pv_length_from_move(pos, best_move);
-
-             bool unstable = false;
-             if (have_prev) {
-                 if (best_move != prev_best_move) unstable = true;
-                 if (best_val < prev_best_score) unstable = true;
-
-                 // Zahak: ExtraTime
-                 if (depth >= 8 && prev_best_score - best_val >= 30) {
-                      int64_t extra = search_context.soft_time_limit / 10;
-                      search_context.soft_time_limit = std::min(search_context.hard_time_limit, search_context.soft_time_limit + extra);
-                 }
+             long long root_nodes = 0;
+             long long best_nodes = 0;
+             for (const auto& rm : root_moves) {
+                 root_nodes += rm.nodes;
+                 if (rm.move == best_move) best_nodes = rm.nodes;
              }
-             search_context.unstable_iteration.store(unstable, std::memory_order_relaxed);
-             prev_best_move = best_move;
-             prev_best_score = best_val;
-             have_prev = true;
+             double effort = (root_nodes > 0) ? static_cast<double>(best_nodes) / root_nodes : 1.0;
+             search_context.time.update(depth, best_move, best_val, effort);
 
              if (!limits.silent) {
-                 std::cout << "info depth " << depth << " score " << score_str
-                           << " time " << ms << " nodes " << search_context.pool->get_total_nodes()
-                           << " nps " << nps << " pv " << get_pv(pos, best_move) << std::endl;
+                 for (int k = 0; k < pv_lines; k++) {
+                     const std::vector<uint16_t>& line_pv = (k == 0) ? pv : root_moves[k].pv;
+                     int line_score = (k == 0) ? best_val : root_moves[k].score;
+                     std::cout << "info depth " << depth;
+                     if (pv_lines > 1) std::cout << " multipv " << (k + 1);
+                     std::cout << " score " << uci_score(line_score)
+                               << " time " << ms << " nodes " << search_context.pool->get_total_nodes()
+                               << " nps " << nps << " hashfull " << TTable.hashfull()
+                               << " pv " << pv_to_uci(line_pv) << std::endl;
+                 }
              }
         }
     }
 
-    if (thread_id == 0) {
-        if (!limits.silent) {
-            std::cout << "bestmove " << move_to_uci(best_move) << std::endl;
-        }
-    }
 }
 
 // ----------------------------------------------------------------------------
@@ -1141,24 +1353,190 @@ void SearchWorker::iter_deep(SearchContext& search_context) {
 // ----------------------------------------------------------------------------
 
 void ThreadPool::init(int thread_count) {
+    release();
+    binding = Numa::binding();
+
+    // Every worker is constructed on a thread pinned like the one that will
+    // search with it, so first-touch places its tables on that NUMA node.
+    std::thread([this] {
+        Numa::bind_thread(0);
+        master = new SearchWorker(0, *context);
+    }).join();
+
+    std::mutex ready_mutex;
+    std::condition_variable ready_cv;
+    int ready = 0;
+    uint64_t seen = generation.load(std::memory_order_acquire);
+    workers.assign(std::max(0, thread_count - 1), nullptr);
+    for (int i = 1; i < thread_count; i++) {
+        threads.emplace_back([this, i, seen, &ready_mutex, &ready_cv, &ready] {
+            Numa::bind_thread(i);
+            SearchWorker* w = new SearchWorker(i, *context);
+            {
+                std::lock_guard<std::mutex> lk(ready_mutex);
+                workers[i - 1] = w;
+                ready++;
+                ready_cv.notify_one();
+            }
+            idle_loop(w, seen);
+        });
+    }
+    std::unique_lock<std::mutex> lk(ready_mutex);
+    ready_cv.wait(lk, [&] { return ready == thread_count - 1; });
+}
+
+void ThreadPool::release() {
+    exiting.store(true, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    generation.notify_all();
+    for (auto& t : threads) t.join();
+    threads.clear();
+    exiting.store(false, std::memory_order_relaxed);
     for (auto* w : workers) delete w;
     workers.clear();
     if (master) { delete master; master = nullptr; }
+}
 
-    master = new SearchWorker(0, *context);
-    for (int i = 1; i < thread_count; i++) {
-        workers.push_back(new SearchWorker(i, *context));
+// Helper threads spin on the generation counter for OptSpinWaitUs after each
+// search (so back-to-back bullet moves start without a wakeup), then park on
+// it with a futex-backed atomic wait until the next search or exit.
+void ThreadPool::idle_loop(SearchWorker* worker, uint64_t seen) {
+    while (true) {
+        if (OptSpinWaitUs > 0 && generation.load(std::memory_order_acquire) == seen) {
+            auto deadline = steady_clock::now() + microseconds(OptSpinWaitUs);
+            int spins = 0;
+            while (generation.load(std::memory_order_acquire) == seen) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+                if ((++spins & 1023) == 0 && steady_clock::now() >= deadline) break;
+            }
+        }
+        while (generation.load(std::memory_order_acquire) == seen) {
+            generation.wait(seen, std::memory_order_acquire);
+        }
+        seen = generation.load(std::memory_order_acquire);
+        if (exiting.load(std::memory_order_relaxed)) return;
+
+        worker->search_loop();
+
+        if (active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            active.notify_all();
+        }
     }
 }
 
 void ThreadPool::start_search(const Position& pos, const SearchLimits& limits) {
     if (master) master->start_search(pos, limits);
     for (auto* w : workers) w->start_search(pos, limits);
+
+    // Deterministic mode: "go nodes N" becomes a fixed budget per thread (the
+    // master takes the remainder; at least one node each, since 0 means no
+    // budget), and iterations run in TT epochs. A single thread is
+    // deterministic as it is.
+    bool epochs = limits.deterministic && !workers.empty();
+    long long threads = (long long)workers.size() + 1;
+    epoch_barrier.reset(epochs ? new std::barrier<EpochMerge>(threads, EpochMerge{this}) : nullptr);
+    if (master) {
+        master->epochs = epochs;
+        master->node_budget = epochs ? limits.nodes / threads + limits.nodes % threads : 0;
+    }
+    for (auto* w : workers) {
+        w->epochs = epochs;
+        w->node_budget = (epochs && limits.nodes > 0) ? std::max<long long>(1, limits.nodes / threads) : 0;
+    }
+
+    if (workers.empty()) return;
+    active.store((int)workers.size(), std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    generation.notify_all();
 }
 
 void ThreadPool::wait_for_completion() {
-    if (master) master->wait_for_completion();
-    for (auto* w : workers) w->wait_for_completion();
+    int remaining;
+    while ((remaining = active.load(std::memory_order_acquire)) != 0) {
+        active.wait(remaining, std::memory_order_acquire);
+    }
+}
+
+// Thread order, so the shared table ends up the same whatever order the
+// threads reached the barrier in
+void ThreadPool::merge_epoch() {
+    auto merge = [](SearchWorker* w) {
+        if (w->epoch_tt) TTable.merge_from(*w->epoch_tt, w->epoch_keys);
+        w->epoch_keys.clear();
+    };
+    if (master) merge(master);
+    for (auto* w : workers) merge(w);
+}
+
+long long ThreadPool::max_start_latency_us() const {
+    long long latency = master ? master->get_start_latency_us() : 0;
+    for (auto* w : workers) latency = std::max(latency, w->get_start_latency_us());
+    return latency;
+}
+
+Stats::Counters ThreadPool::total_stats() const {
+    Stats::Counters total;
+    auto add = [&total](const SearchWorker* w) {
+        Stats::Counters c = w->stats;
+        c.pawn_hits = w->pawn_table.hits;
+        c.pawn_misses = w->pawn_table.misses;
+        c.material_hits = w->material_table.hits;
+        c.material_misses = w->material_table.misses;
+        total += c;
+    };
+    if (master) add(master);
+    for (auto* w : workers) add(w);
+    return total;
+}
+
+void ThreadPool::reset_stats() {
+    auto reset = [](SearchWorker* w) {
+        w->stats = Stats::Counters();
+        w->pawn_table.hits = w->pawn_table.misses = 0;
+        w->material_table.hits = w->material_table.misses = 0;
+    };
+    if (master) reset(master);
+    for (auto* w : workers) reset(w);
+}
+
+SearchWorker* ThreadPool::best_thread() const {
+    if (!master) return nullptr;
+    if (master->tb_root || workers.empty() || master->limits.multi_pv > 1) return master;
+
+    std::vector<SearchWorker*> all;
+    all.push_back(master);
+    for (auto* w : workers) {
+        if (w->best_move != 0 && w->depth_reached > 0) all.push_back(w);
+    }
+
+    // Depth/score voting: every thread backs its move with a weight that
+    // grows with both its completed depth and its score above the worst.
+    int min_score = master->best_score;
+    for (auto* w : all) min_score = std::min(min_score, w->best_score);
+
+    std::vector<std::pair<uint16_t, long long>> votes;
+    auto vote_of = [&votes](uint16_t m) -> long long& {
+        for (auto& v : votes) if (v.first == m) return v.second;
+        votes.push_back({m, 0});
+        return votes.back().second;
+    };
+    for (auto* w : all) {
+        vote_of(w->best_move) += (long long)(w->best_score - min_score + 14) * w->depth_reached;
+    }
+
+    SearchWorker* best = master;
+    for (auto* w : all) {
+        if (w == best) continue;
+        if (std::abs(best->best_score) >= MATE_TH) {
+            // Prefer the shortest proven mate
+            if (w->best_score > best->best_score) best = w;
+        } else if (w->best_score >= MATE_TH || vote_of(w->best_move) > vote_of(best->best_move)) {
+            best = w;
+        }
+    }
+    return best;
 }
 
 long long ThreadPool::get_total_nodes() const {
@@ -1169,8 +1547,7 @@ long long ThreadPool::get_total_nodes() const {
 }
 
 ThreadPool::~ThreadPool() {
-    for (auto* w : workers) delete w;
-    if (master) delete master;
+    release();
 }
 
 // ----------------------------------------------------------------------------
@@ -1190,57 +1567,75 @@ SearchResult Search::search(Position& pos, const SearchLimits& limits, SearchCon
     if (limits.use_global_context) {
         SearchContext::active_context.store(&context, std::memory_order_release);
     }
+#ifdef TUNE
+    context.init_lmr(); // LMR coefficients may have changed through setoption
+#else
     std::call_once(context.lmr_once, [&context]() { context.init_lmr(); });
+#endif
 
-    if (!context.pool->master || (int)context.pool->workers.size() + 1 != OptThreads) {
+    if (!context.pool->master || (int)context.pool->workers.size() + 1 != OptThreads
+        || context.pool->binding != Numa::binding()) {
         context.pool->init(OptThreads);
     }
 
     context.stop_flag = false;
+    context.pondering = limits.ponder;
     context.start_time = steady_clock::now();
     context.options = limits;
     context.nodes_limit_count = limits.nodes;
-    context.unstable_iteration.store(false, std::memory_order_relaxed);
-
-    // Time Management
-    context.soft_time_limit = 0;
-    context.hard_time_limit = 0;
-    if (!limits.infinite && limits.move_time == 0) {
-         int color = pos.side_to_move();
-         int t = limits.time[color];
-         int i = limits.inc[color];
-         int m = limits.movestogo > 0 ? limits.movestogo : 30;
-         if (t > 0) {
-             int safe_time = std::max(0, t - limits.move_overhead_ms);
-             int base_time = (t / m) + (i * 3 / 4);
-             int soft_limit = std::min(base_time, safe_time);
-             int hard_limit = std::min((t / m) + i, safe_time);
-             context.soft_time_limit = soft_limit;
-             context.hard_time_limit = std::max<int64_t>(soft_limit, hard_limit);
-         }
-    } else if (limits.move_time > 0) {
-        // Modified: Use move_overhead_ms
-        int64_t limit = std::max(0, limits.move_time - limits.move_overhead_ms);
-        context.soft_time_limit = limit;
-        context.hard_time_limit = limit;
-    }
+    context.nodes_near_limit.store(false, std::memory_order_relaxed);
+
+    context.time.init(limits, pos.side_to_move());
 
     if (limits.use_tt_new_search) {
         TTable.new_search();
     }
     context.pool->start_search(pos, limits);
+    // The master searches on the calling thread: handing it to a pool thread
+    // would add a wake-up to every search, and the caller only waits anyway
     context.pool->master->search_loop();
+    if (context.pool->deterministic() && !context.time.enabled()) {
+        // Helpers finish their own budgets or depth; stopping them when the
+        // master is done would make their last TT writes timing dependent
+        context.pool->wait_for_completion();
+    }
+
+    // UCI forbids bestmove during ponder or infinite search before
+    // ponderhit/stop, even if the search itself has finished
+    while (!context.stop_flag && (context.pondering || limits.infinite)) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
 
     context.stop_flag = true;
     context.pool->wait_for_completion();
+    if (context.pool->deterministic()) context.pool->merge_epoch(); // Writes of the final, partial epoch
 
     SearchResult result;
-    if (context.pool->master) {
-        result.best_move = context.pool->master->best_move;
-        result.best_score_cp = context.pool->master->best_score;
-        result.depth_reached = context.pool->master->depth_reached;
-        result.pv_length = context.pool->master->pv_length;
-        result.root_scores = context.pool->master->root_scores;
+    SearchWorker* best = context.pool->best_thread();
+    if (best) {
+        result.best_move = best->best_move;
+        result.best_score_cp = best->best_score;
+        result.depth_reached = best->depth_reached;
+        result.pv = best->pv;
+        result.pv_length = (int)best->pv.size();
+        result.root_scores = best->root_scores;
+    }
+    result.elapsed_ms = duration_cast<milliseconds>(steady_clock::now() - context.start_time).count();
+    result.time_optimum_ms = context.time.optimum();
+    result.time_maximum_ms = context.time.maximum();
+    // Long untimed analysis is where a small hash costs the most
+    if (!limits.silent && !context.time.enabled() && result.elapsed_ms >= 10000) {
+        print_occupancy(std::cout, TTable);
+    }
+    if (!limits.silent && best) {
+        if (best != context.pool->master && best->best_move != 0) {
+            std::cout << "info depth " << best->depth_reached << " score " << uci_score(best->best_score)
+                      << " nodes " << context.pool->get_total_nodes()
+                      << " pv " << pv_to_uci(best->pv) << std::endl;
+        }
+        std::cout << "bestmove " << move_to_uci(best->best_move);
+        if (best->pv.size() > 1) std::cout << " ponder " << move_to_uci(best->pv[1]);
+        std::cout << std::endl;
     }
     return result;
 }
@@ -1252,11 +1647,22 @@ void Search::stop() {
     }
 }
 
+// The opponent played the expected move: the search carries on under the
+// budget computed at "go ponder", counted from the start of pondering, so
+// time spent pondering is time the real search does not need again.
+void Search::ponderhit() {
+    SearchContext* context = SearchContext::active_context.load(std::memory_order_acquire);
+    if (context) {
+        context->pondering = false;
+    }
+}
+
 void Search::clear() {
     TTable.clear();
     SearchContext* context = SearchContext::active_context.load(std::memory_order_acquire);
     if (context && context->pool && context->pool->master) {
         context->pool->master->clear_history();
+        for (auto* w : context->pool->workers) w->clear_history();
     }
 }
 
@@ -1264,3 +1670,18 @@ long long Search::get_node_count() {
     SearchContext* context = SearchContext::active_context.load(std::memory_order_acquire);
     return context ? context->get_node_count() : 0;
 }
+
+long long Search::get_start_latency_us() {
+    SearchContext* context = SearchContext::active_context.load(std::memory_order_acquire);
+    return (context && context->pool) ? context->pool->max_start_latency_us() : 0;
+}
+
+Stats::Counters Search::stats() {
+    SearchContext* context = SearchContext::active_context.load(std::memory_order_acquire);
+    return (context && context->pool) ? context->pool->total_stats() : Stats::Counters();
+}
+
+void Search::reset_stats() {
+    SearchContext* context = SearchContext::active_context.load(std::memory_order_acquire);
+    if (context && context->pool) context->pool->reset_stats();
+}
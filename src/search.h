@@ -2,6 +2,8 @@
 #define SEARCH_H
 
 #include "position.h"
+#include "timeman.h"
+#include "stats.h"
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -14,14 +16,27 @@ struct Move;
 namespace TT { class TranspositionTable; }
 
 extern int OptThreads; // Global thread count option
+extern int OptSpinWaitUs; // Helper spin time before parking between searches
+
+// Where quiescence stores its results: the shared TT, a small per-thread
+// table, or the per-thread table for stand-pat cutoffs only. Quiescence
+// probes the per-thread table (if any) before the shared one.
+enum class QsTTPolicy { Shared, Local, Split };
 
 struct SearchLimits {
     int depth = 0;
     int64_t nodes = 0;
     int move_time = 0;
     bool infinite = false;
+    bool ponder = false;                // Untimed until ponderhit
+    std::vector<uint16_t> search_moves; // Root restriction; empty = all moves
     bool silent = false;
     uint64_t seed = 0;
+    int multi_pv = 1; // Root lines searched with exact scores
+    bool deterministic = false; // Reproducible multi-threaded node/depth searches
+    QsTTPolicy qs_tt = QsTTPolicy::Shared;
+    int qs_hash_mb = 1; // Per-thread quiescence table, unless Shared
+    int pawn_hash_mb = 1; // Per-thread pawn structure cache
 
     // Time management fields
     int time[2] = {0, 0}; // wtime, btime
@@ -34,7 +49,7 @@ struct SearchLimits {
 
     // Options
     bool use_nmp = true;
-    bool use_probcut = true;
+    bool use_probcut = false;
     bool use_singular = true;
     bool use_history = true;
     bool use_tt_new_search = true;
@@ -46,11 +61,18 @@ struct SearchResult {
     int best_score_cp = 0;
     int depth_reached = 0;
     int pv_length = 0;
+    std::vector<uint16_t> pv;
     struct RootScore {
         uint16_t move = 0;
         int score = 0;
     };
+    // Sorted best first; only the first multi_pv scores are exact, the rest
+    // are bounds from null-window root searches.
     std::vector<RootScore> root_scores;
+    // Clock use; optimum is the final scaled value (0 = no time control)
+    int64_t elapsed_ms = 0;
+    int64_t time_optimum_ms = 0;
+    int64_t time_maximum_ms = 0;
 };
 
 class ThreadPool;
@@ -58,10 +80,10 @@ class ThreadPool;
 struct SearchContext {
     SearchLimits options;
     std::atomic<bool> stop_flag{false};
-    int64_t soft_time_limit = 0;
-    int64_t hard_time_limit = 0;
+    std::atomic<bool> pondering{false}; // Cleared by ponderhit; time checks wait for it
+    TimeManager time;
     int64_t nodes_limit_count = 0;
-    std::atomic<bool> unstable_iteration{false};
+    std::atomic<bool> nodes_near_limit{false}; // Check the node limit at every node
     std::chrono::steady_clock::time_point start_time;
     int quiet_lmr[64][64]{};
     int noisy_lmr[64][64]{};
@@ -87,9 +109,13 @@ public:
     static SearchResult search(Position& pos, const SearchLimits& limits);
     static SearchResult search(Position& pos, const SearchLimits& limits, SearchContext& context);
     static void stop();
+    static void ponderhit();
     static void clear();
 
     static long long get_node_count();
+    static long long get_start_latency_us(); // Slowest worker, last search
+    static Stats::Counters stats();          // Summed over workers since reset_stats()
+    static void reset_stats();
 };
 
 #endif // SEARCH_H
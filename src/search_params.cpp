@@ -0,0 +1,49 @@
+#include "search_params.h"
+#include <algorithm>
+
+namespace SearchParams {
+
+const std::vector<Tunable>& tunables() {
+#ifdef TUNE
+#define SEARCH_PARAM(name, value, min, max, step) {#name, value, min, max, step, &name},
+#else
+#define SEARCH_PARAM(name, value, min, max, step) {#name, value, min, max, step, nullptr},
+#endif
+    static const std::vector<Tunable> list = { SEARCH_TUNABLES(SEARCH_PARAM) };
+#undef SEARCH_PARAM
+    return list;
+}
+
+bool set_tunable(const std::string& name, int value) {
+    for (const Tunable& t : tunables()) {
+        if (name != t.name) continue;
+        if (!t.value) return false;
+        *t.value = std::clamp(value, t.min, t.max);
+        return true;
+    }
+    return false;
+}
+
+void print_tunables(std::ostream& out, bool json) {
+    const std::vector<Tunable>& list = tunables();
+    if (json) out << "{\n";
+    for (size_t i = 0; i < list.size(); i++) {
+        const Tunable& t = list[i];
+        int current = t.value ? *t.value : t.default_value;
+        if (json) {
+            out << "    \"" << t.name << "\": {\n"
+                << "        \"value\": " << current << ",\n"
+                << "        \"min_value\": " << t.min << ",\n"
+                << "        \"max_value\": " << t.max << ",\n"
+                << "        \"step\": " << t.step << "\n"
+                << "    }" << (i + 1 < list.size() ? "," : "") << "\n";
+        } else {
+            out << t.name << ", int, " << current << ", " << t.min << ", " << t.max
+                << ", " << t.step << ", 0.002\n";
+        }
+    }
+    if (json) out << "}\n";
+    out << std::flush;
+}
+
+}
@@ -1,39 +1,87 @@
 #ifndef SEARCH_PARAMS_H
 #define SEARCH_PARAMS_H
 
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Tunable search parameters: name, default, min, max, SPSA step.
+// Release builds fold them into constants. Building with -DTUNE (make tune)
+// turns them into globals that are exposed as UCI spin options, so a tuner
+// can move them between games without a rebuild.
+// LMR_* are the reduction formula coefficients scaled by 100.
+#define SEARCH_TUNABLES(X) \
+    X(RFP_MARGIN,                64,    20,  150,   6) \
+    X(RAZORING_MARGIN,          339,   150,  600,  25) \
+    X(FUTILITY_MARGIN,           97,    40,  200,   8) \
+    X(DELTA_MARGIN,             345,   150,  600,  25) \
+    X(TP_MARGIN,                 35,    10,  100,   5) \
+    X(NMP_DEPTH_LIMIT,            2,     1,    5,   1) \
+    X(NMP_BASE_REDUCTION,         4,     2,    6,   1) \
+    X(NMP_DIVISOR,                4,     2,    8,   1) \
+    X(NMP_EVAL_MARGIN,          100,    30,  300,  15) \
+    X(HISTORY_PRUNE_DEPTH,        3,     1,    6,   1) \
+    X(HISTORY_PRUNE_THRESHOLD, -800, -4000,    0, 200) \
+    X(PROBCUT_DEPTH,              5,     3,    8,   1) \
+    X(PROBCUT_MARGIN,           200,    80,  400,  15) \
+    X(PROBCUT_REDUCTION,          4,     2,    6,   1) \
+    X(LMR_QUIET_BASE,            80,     0,  200,   8) \
+    X(LMR_QUIET_DIVISOR,        250,   150,  400,  12) \
+    X(LMR_NOISY_BASE,             0,  -100,  100,   8) \
+    X(LMR_NOISY_DIVISOR,        350,   200,  500,  15) \
+    X(ASPIRATION_DELTA,          20,     8,   60,   3)
+
 namespace SearchParams {
 
+#ifdef TUNE
+#define SEARCH_PARAM(name, value, min, max, step) inline int name = value;
+#else
+#define SEARCH_PARAM(name, value, min, max, step) constexpr int name = value;
+#endif
+    SEARCH_TUNABLES(SEARCH_PARAM)
+#undef SEARCH_PARAM
+
     // Time Management
     constexpr int MOVE_OVERHEAD_DEFAULT = 10;
 
-    // Pruning Margins
-    constexpr int RFP_MARGIN = 64;
-    constexpr int RAZORING_MARGIN = 339;
-    constexpr int FUTILITY_MARGIN = 97;
-    constexpr int DELTA_MARGIN = 345;
-    constexpr int TP_MARGIN = 35;
+    // Pruning Margins (not yet wired into the search)
     constexpr int RANGE_REDUCTION_MARGIN = 74;
     constexpr int LMR_CAPTURE_MARGIN = 84;
 
     constexpr int SINGULAR_MARGIN = 2; // Used as (3 * depth / 2) in logic, or we can adjust logic
 
-    // NMP
-    constexpr int NMP_DEPTH_LIMIT = 2; // Zahak: depthLeft >= 2
-    constexpr int NMP_BASE_REDUCTION = 4; // Zahak: 4 + min(d/4, 3)
-    constexpr int NMP_DIVISOR = 4;
-
     // History
     constexpr int HISTORY_MAX = 16384; // Zahak uses standard history? Code says 1024 weight * something. Aether uses 16384. Zahak: `AddHistory` not fully visible, but `QuietHistory` usage divides by 10649.
     // Zahak `search.go`: `e.searchHistory.QuietHistory(gpMove, currentMove, move) / 10649`
     // I will keep Aether's history params for now unless I see Zahak's implementation of History being radically different.
     constexpr int HISTORY_DECAY = 16;
-    constexpr int HISTORY_PRUNE_DEPTH = 3;
-    constexpr int HISTORY_PRUNE_THRESHOLD = -800; // Zahak: historyThreashold := int32(depthLeft) * -1024. This is dynamic!
-    // I will handle dynamic threshold in search.cpp
+
+    // Correction History
+    constexpr int CORR_HISTORY_GRAIN = 256;          // Table units per centipawn
+    constexpr int CORR_HISTORY_WEIGHT_SCALE = 1024;
+    constexpr int CORR_HISTORY_MAX = 32 * CORR_HISTORY_GRAIN;
 
     // See
     constexpr int SEE_GOOD_CAPTURE = 0;
 
+    struct Tunable {
+        const char* name;
+        int default_value;
+        int min;
+        int max;
+        int step;
+        int* value; // nullptr unless built with TUNE
+    };
+
+    const std::vector<Tunable>& tunables();
+
+    // Sets a tunable by UCI option name; false if unknown or not a TUNE build
+    bool set_tunable(const std::string& name, int value);
+
+    // OpenBench SPSA lines ("NAME, int, value, min, max, step, 0.002"),
+    // or the weather-factory JSON config when json is set
+    void print_tunables(std::ostream& out, bool json);
+
 }
 
 #endif // SEARCH_PARAMS_H
@@ -0,0 +1,53 @@
+#include "stats.h"
+#include <iomanip>
+
+namespace Stats {
+
+Counters& Counters::operator+=(const Counters& other) {
+#define STAT_ADD(name, label) name += other.name;
+    SEARCH_STATS(STAT_ADD)
+#undef STAT_ADD
+    return *this;
+}
+
+namespace {
+
+double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+}
+
+}
+
+void print_table(std::ostream& out, const Counters& c) {
+    out << "Search statistics\n";
+#define STAT_ROW(name, label) out << "  " << std::left << std::setw(30) << label << std::right << std::setw(14) << c.name << "\n";
+    SEARCH_STATS(STAT_ROW)
+#undef STAT_ROW
+    out << std::fixed << std::setprecision(1)
+        << "  " << std::left << std::setw(30) << "TT hit rate at depth >= 4" << std::right << std::setw(13)
+        << percent(c.tt_deep_hits, c.tt_deep_probes) << "%\n"
+        << "  " << std::left << std::setw(30) << "first-move cutoff rate" << std::right << std::setw(13)
+        << percent(c.first_move_cutoffs, c.beta_cutoffs) << "%\n"
+        << "  " << std::left << std::setw(30) << "null-move success rate" << std::right << std::setw(13)
+        << percent(c.nmp_cutoffs, c.nmp_tries) << "%\n"
+        << "  " << std::left << std::setw(30) << "LMR re-search rate" << std::right << std::setw(13)
+        << percent(c.lmr_researches, c.lmr_searches) << "%\n"
+        << "  " << std::left << std::setw(30) << "quiescence share of nodes" << std::right << std::setw(13)
+        << percent(c.qs_nodes, c.nodes + c.qs_nodes) << "%\n"
+        << "  " << std::left << std::setw(30) << "pawn hash hit rate" << std::right << std::setw(13)
+        << percent(c.pawn_hits, c.pawn_hits + c.pawn_misses) << "%\n"
+        << "  " << std::left << std::setw(30) << "material hash hit rate" << std::right << std::setw(13)
+        << percent(c.material_hits, c.material_hits + c.material_misses) << "%\n";
+    out << std::defaultfloat << std::setprecision(6) << std::flush;
+}
+
+void print_json(std::ostream& out, const Counters& c) {
+    out << "{";
+    const char* sep = "";
+#define STAT_JSON(name, label) out << sep << "\"" #name "\": " << c.name; sep = ", ";
+    SEARCH_STATS(STAT_JSON)
+#undef STAT_JSON
+    out << "}" << std::endl;
+}
+
+}
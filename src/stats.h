@@ -0,0 +1,68 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <ostream>
+
+// Search instrumentation. Counters live in each SearchWorker as plain
+// integers and are summed on demand. Unless built with -DSTATS (make stats)
+// STAT_INC expands to nothing, so release builds pay nothing for it.
+#define SEARCH_STATS(X) \
+    X(nodes,               "main search nodes") \
+    X(qs_nodes,            "quiescence nodes") \
+    X(tt_deep_probes,      "TT probes at depth >= 4") \
+    X(tt_deep_hits,        "TT hits at depth >= 4") \
+    X(tt_cutoffs,          "TT cutoffs") \
+    X(qs_tt_cutoffs,       "quiescence TT cutoffs") \
+    X(rfp_cutoffs,         "reverse futility cutoffs") \
+    X(nmp_tries,           "null-move searches") \
+    X(nmp_cutoffs,         "null-move cutoffs") \
+    X(probcut_tries,       "ProbCut verifications") \
+    X(probcut_cutoffs,     "ProbCut cutoffs") \
+    X(razor_returns,       "razoring returns") \
+    X(singular_extensions, "singular extensions") \
+    X(multicut_cutoffs,    "multi-cut cutoffs") \
+    X(lmp_prunes,          "late-move prunes") \
+    X(futility_prunes,     "futility prunes") \
+    X(history_prunes,      "history prunes") \
+    X(lmr_searches,        "reduced searches") \
+    X(lmr_researches,      "LMR re-searches") \
+    X(pvs_researches,      "PVS full-window re-searches") \
+    X(pawn_hits,           "pawn hash hits (HCE)") \
+    X(pawn_misses,         "pawn hash misses (HCE)") \
+    X(material_hits,       "material hash hits") \
+    X(material_misses,     "material hash misses") \
+    X(beta_cutoffs,        "beta cutoffs") \
+    X(first_move_cutoffs,  "first-move beta cutoffs")
+
+#ifdef STATS
+#define STAT_INC(counter) (stats.counter++)
+#else
+#define STAT_INC(counter) ((void)0)
+#endif
+
+namespace Stats {
+
+    constexpr bool enabled =
+#ifdef STATS
+        true;
+#else
+        false;
+#endif
+
+    struct Counters {
+#define STAT_FIELD(name, label) uint64_t name = 0;
+        SEARCH_STATS(STAT_FIELD)
+#undef STAT_FIELD
+
+        Counters& operator+=(const Counters& other);
+    };
+
+    // Aligned table followed by derived rates
+    void print_table(std::ostream& out, const Counters& c);
+    // Single-line JSON object with every counter
+    void print_json(std::ostream& out, const Counters& c);
+
+}
+
+#endif // STATS_H
@@ -0,0 +1,79 @@
+#include "timeman.h"
+#include "search.h"
+#include <algorithm>
+
+namespace {
+
+// Optimum multiplier by number of iterations the best move has held
+constexpr double StabilityScale[] = {2.2, 1.6, 1.3, 1.1, 1.0, 0.95, 0.9, 0.85};
+
+// A running iteration is abandoned only past this multiple of the optimum:
+// iterations may start up to 0.7x it, and cutting them at 1x wastes most of
+// their work
+constexpr double ABORT_SCALE = 2.0;
+
+// Iterations below this depth are too shallow to say much about the move
+constexpr int MIN_SCALING_DEPTH = 4;
+
+}
+
+void TimeManager::init(const SearchLimits& limits, Color us) {
+    base_ms = optimum_ms = maximum_ms = 0;
+    fixed = false;
+    last_best_move = 0;
+    stability = 0;
+    iterations = 0;
+
+    if (limits.infinite) return;
+
+    if (limits.move_time > 0) {
+        int64_t limit = std::max(0, limits.move_time - limits.move_overhead_ms);
+        base_ms = optimum_ms = maximum_ms = limit;
+        fixed = true;
+        return;
+    }
+
+    int t = limits.time[us];
+    int inc = limits.inc[us];
+    if (t <= 0) return;
+
+    int m = limits.movestogo > 0 ? limits.movestogo : 30;
+    int64_t safe = std::max(0, t - limits.move_overhead_ms);
+    base_ms = std::min<int64_t>((t / m) + (inc * 3 / 4), safe);
+    optimum_ms = base_ms;
+    // Room to overrun the optimum on unsettled moves, but never more than a
+    // quarter of the clock (plus increment) beyond it
+    maximum_ms = std::min(safe, std::max(base_ms, std::min<int64_t>(base_ms * 3, safe / 4 + inc)));
+}
+
+void TimeManager::update(int depth, uint16_t best_move, int score, double best_move_effort) {
+    if (!enabled() || fixed) return;
+
+    stability = (best_move == last_best_move) ? std::min(stability + 1, 7) : 0;
+    last_best_move = best_move;
+
+    // Score trend against the oldest of the last three iterations (newest first)
+    int drop = (iterations > 0) ? score_history[std::min(iterations, 3) - 1] - score : 0;
+    for (int i = 2; i > 0; i--) score_history[i] = score_history[i - 1];
+    score_history[0] = score;
+    iterations++;
+
+    if (depth < MIN_SCALING_DEPTH) return;
+
+    double effort_scale = std::clamp((1.5 - best_move_effort) * 1.35, 0.5, 2.0);
+    double score_scale = std::clamp(1.0 + drop * 0.008, 0.85, 1.5);
+    double scale = effort_scale * StabilityScale[stability] * score_scale;
+    optimum_ms = std::min(maximum_ms, static_cast<int64_t>(base_ms * scale));
+}
+
+// The next iteration usually takes longer than all previous ones together,
+// so only start it while well inside the optimum
+bool TimeManager::can_start_iteration(int64_t elapsed_ms) const {
+    if (!enabled()) return true;
+    return elapsed_ms <= 0.7 * optimum_ms;
+}
+
+bool TimeManager::must_stop(int64_t elapsed_ms, bool have_result) const {
+    if (!enabled()) return false;
+    return elapsed_ms >= maximum_ms || (have_result && elapsed_ms >= ABORT_SCALE * optimum_ms);
+}
@@ -0,0 +1,41 @@
+#ifndef TIMEMAN_H
+#define TIMEMAN_H
+
+#include "types.h"
+#include <cstdint>
+
+struct SearchLimits;
+
+// Per-move time budget. The maximum is fixed when the search starts; the
+// optimum is rescaled after every completed iteration from how settled the
+// search looks (share of root nodes spent on the best move, how long the best
+// move has held, and whether the score is falling).
+class TimeManager {
+public:
+    void init(const SearchLimits& limits, Color us);
+
+    // Master only, after each completed iteration. best_move_effort is the
+    // fraction of that iteration's root nodes spent below the best move.
+    void update(int depth, uint16_t best_move, int score, double best_move_effort);
+
+    bool enabled() const { return maximum_ms > 0; }
+    bool can_start_iteration(int64_t elapsed_ms) const;
+    // Mid-iteration stop: the maximum, or well past the optimum once an
+    // iteration has completed
+    bool must_stop(int64_t elapsed_ms, bool have_result) const;
+    int64_t optimum() const { return optimum_ms; }
+    int64_t maximum() const { return maximum_ms; }
+
+private:
+    int64_t base_ms = 0;     // Optimum before scaling
+    int64_t optimum_ms = 0;
+    int64_t maximum_ms = 0;
+    bool fixed = false;      // movetime: no scaling
+
+    uint16_t last_best_move = 0;
+    int stability = 0;       // Iterations the best move has held
+    int score_history[3] = {0, 0, 0};
+    int iterations = 0;
+};
+
+#endif // TIMEMAN_H
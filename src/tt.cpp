@@ -1,30 +1,92 @@
 #include "tt.h"
+#include "numa.h"
+#include "memory.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <new>
+#include <thread>
 
-#if defined(_WIN32)
-#include <windows.h>
-#elif defined(__linux__)
+#if defined(__linux__)
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 TranspositionTable TTable;
 
 // Static assert to ensure packing
-static_assert(sizeof(TTEntry) == 16, "TTEntry must be 16 bytes");
+static_assert(sizeof(TTEntry) == 8, "TTEntry must pack into one word");
+static_assert(sizeof(TTBucket) == 32, "TTBucket must be 32 bytes");
 
 namespace {
 constexpr size_t kLargePageThresholdMb = 256;
+constexpr size_t kClearBytesPerThread = 64ULL * 1024 * 1024;
 
-size_t large_page_size_bytes() {
-#if defined(_WIN32)
-    return static_cast<size_t>(GetLargePageMinimum());
-#elif defined(__linux__)
-    return 2ULL * 1024 * 1024;
-#else
-    return 0;
-#endif
+// Generation bits of a packed TTEntry; refreshing them must not break the key check
+constexpr uint64_t kGenBits = std::bit_cast<uint64_t>(TTEntry{0, 0, 0, 0, 0xFC});
+
+uint16_t data_check(uint64_t data) {
+    return (uint16_t)(((data & ~kGenBits) * 0x9E3779B97F4A7C15ULL) >> 48);
+}
+
+// Slots are shared between search threads without locks; every access is a
+// single relaxed atomic load or store (plain moves on x86)
+template <typename T>
+T load_word(const T& word) {
+    return std::atomic_ref<T>(const_cast<T&>(word)).load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void store_word(T& word, T value) {
+    std::atomic_ref<T>(word).store(value, std::memory_order_relaxed);
 }
+
+uint64_t xorshift(uint64_t& s) {
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+    return s * 2685821657736338717ULL;
+}
+
+// Hash file header; the clusters start at kFileDataOffset so a mapping of the
+// file keeps them page aligned
+struct TTFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bucket_bytes;
+    uint64_t num_buckets;
+    uint64_t tag;
+    uint8_t generation;
+};
+constexpr char kFileMagic[8] = {'A', 'E', 'T', 'H', 'E', 'R', 'T', 'T'};
+constexpr uint32_t kFileVersion = 1;
+constexpr size_t kFileDataOffset = 4096;
+constexpr size_t kFileChunk = 64ULL * 1024 * 1024;
+constexpr size_t kMaxFileMb = 65536; // The Hash option's maximum
+
+TTFileHeader make_header(size_t num_buckets, uint64_t tag, uint8_t generation) {
+    TTFileHeader h{};
+    std::memcpy(h.magic, kFileMagic, sizeof(h.magic));
+    h.version = kFileVersion;
+    h.bucket_bytes = sizeof(TTBucket);
+    h.num_buckets = num_buckets;
+    h.tag = tag;
+    h.generation = generation;
+    return h;
+}
+
+bool header_valid(const TTFileHeader& h) {
+    return std::memcmp(h.magic, kFileMagic, sizeof(h.magic)) == 0 && h.version == kFileVersion
+        && h.bucket_bytes == sizeof(TTBucket) && h.num_buckets > 0;
+}
+
 } // namespace
 
 TranspositionTable::TranspositionTable(size_t size_mb) {
@@ -37,191 +99,448 @@ TranspositionTable::~TranspositionTable() {
 }
 
 void TranspositionTable::resize(size_t size_mb) {
-    size_t size_bytes = size_mb * 1024 * 1024;
-    size_t bucket_size = sizeof(TTBucket);
-    size_t target_buckets = size_bytes / bucket_size;
-
-    // Power of two
-    size_t desired_buckets = 1;
-    while (desired_buckets * 2 <= target_buckets) desired_buckets *= 2;
-
-    bool want_large_pages = use_large_pages && size_mb >= kLargePageThresholdMb;
-    size_t alloc_buckets = desired_buckets;
-
-    if (want_large_pages) {
-        size_t page_size = large_page_size_bytes();
-        if (page_size == 0) {
-            want_large_pages = false;
-        } else {
-            while (alloc_buckets > 1 && ((alloc_buckets * bucket_size) % page_size) != 0) {
-                alloc_buckets /= 2;
-            }
-        }
-    }
-
     release();
-    num_buckets = alloc_buckets;
-    size_t alloc_bytes = num_buckets * bucket_size;
+    num_buckets = std::max<size_t>(1, size_mb * 1024 * 1024 / sizeof(TTBucket));
+    size_t bytes = num_buckets * sizeof(TTBucket);
+    restored = false;
 
-    if (!(want_large_pages && alloc_bytes > 0 && allocate_large_pages(alloc_bytes))) {
-        allocate_standard(num_buckets);
+    if (!backing_path.empty() && map_file(bytes)) {
+        if (!restored) clear();
+        return;
     }
 
-    clear();
-}
+    // Left unzeroed: zero-filling here would first-touch every page on this
+    // thread, before the NUMA policy is set and without parallelism
+    bool allow_hugetlb = size_mb >= kLargePageThresholdMb;
+    buckets = static_cast<TTBucket*>(Memory::alloc_large(bytes, allow_hugetlb, &page_kind));
+    if (!buckets) {
+        num_buckets = 0;
+        throw std::bad_alloc();
+    }
 
-void TranspositionTable::set_large_pages(bool enabled) {
-    use_large_pages = enabled;
+    // The TT is shared by every search thread; spread it over all nodes.
+    // Nothing has touched the pages yet, so clear() places them.
+    Numa::interleave(buckets, bytes);
+
+    clear();
 }
 
 void TranspositionTable::release() {
-    if (using_large_pages && buckets != nullptr) {
-#if defined(_WIN32)
-        VirtualFree(buckets, 0, MEM_RELEASE);
-#elif defined(__linux__)
-        munmap(buckets, num_buckets * sizeof(TTBucket));
+    if (map_base) {
+#if defined(__linux__)
+        munmap(map_base, map_bytes);
 #endif
+        map_base = nullptr;
+        map_bytes = 0;
+    } else {
+        Memory::free_large(buckets);
     }
-
     buckets = nullptr;
-    using_large_pages = false;
-    fallback_buckets.clear();
-    fallback_buckets.shrink_to_fit();
     num_buckets = 0;
 }
 
-bool TranspositionTable::allocate_large_pages(size_t bytes) {
-#if defined(_WIN32)
-    void* mem = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
-    if (!mem) return false;
-    buckets = static_cast<TTBucket*>(mem);
-    using_large_pages = true;
-    return true;
-#elif defined(__linux__)
-    void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
-                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
-    if (mem == MAP_FAILED) return false;
-    buckets = static_cast<TTBucket*>(mem);
-    using_large_pages = true;
-    return true;
-#else
-    (void)bytes;
-    return false;
-#endif
-}
-
-void TranspositionTable::allocate_standard(size_t bucket_count) {
-    fallback_buckets.clear();
-    fallback_buckets.resize(bucket_count);
-    buckets = fallback_buckets.data();
-    using_large_pages = false;
-}
-
 void TranspositionTable::clear() {
-    if (buckets && num_buckets > 0) {
-        std::memset(buckets, 0, num_buckets * sizeof(TTBucket));
+    auto start = std::chrono::steady_clock::now();
+    size_t bytes = num_buckets * sizeof(TTBucket);
+    // Small tables are not worth starting threads for
+    size_t threads = std::clamp<size_t>(bytes / kClearBytesPerThread, 1, clear_threads);
+
+    if (buckets && threads > 1) {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([this, t, threads] {
+                Numa::bind_thread((int)t);
+                size_t begin = num_buckets * t / threads;
+                size_t end = num_buckets * (t + 1) / threads;
+                std::memset(static_cast<void*>(buckets + begin), 0, (end - begin) * sizeof(TTBucket));
+            });
+        }
+        for (auto& w : workers) w.join();
+    } else if (buckets) {
+        std::memset(static_cast<void*>(buckets), 0, bytes);
     }
+
     current_gen = 0;
+    if (map_base) static_cast<TTFileHeader*>(map_base)->generation = 0;
+    clear_threads_used = (int)threads;
+    clear_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
 void TranspositionTable::new_search() {
     current_gen++; // wraps 0-255 naturally
+    if (map_base) static_cast<TTFileHeader*>(map_base)->generation = current_gen;
+}
+
+bool TranspositionTable::slot_matches(const TTBucket& bucket, int i, Key key, uint64_t data) {
+    if (std::bit_cast<TTEntry>(data).bound() == 0) return false;
+    return (uint16_t)(load_word(bucket.key16[i]) ^ data_check(data)) == (uint16_t)key;
+}
+
+void TranspositionTable::write_slot(TTBucket& bucket, int i, Key key, const TTEntry& entry) {
+    uint64_t data = std::bit_cast<uint64_t>(entry);
+    store_word(bucket.data[i], data);
+    store_word(bucket.key16[i], (uint16_t)((uint16_t)key ^ data_check(data)));
 }
 
 bool TranspositionTable::probe(Key key, TTEntry& entry) {
-    size_t idx = key & (num_buckets - 1); // Power of 2 mask
-    TTBucket& bucket = buckets[idx];
-
-    for (int i = 0; i < 2; i++) {
-        if (bucket.entries[i].key == key) {
-            entry = bucket.entries[i];
-            // Refresh generation
-            bucket.entries[i].set_gen(current_gen);
-            return true;
+    TTBucket& bucket = bucket_of(key);
+
+    for (int i = 0; i < TT_CLUSTER_SIZE; i++) {
+        uint64_t data = load_word(bucket.data[i]);
+        if (!slot_matches(bucket, i, key, data)) continue;
+        entry = std::bit_cast<TTEntry>(data);
+        if (entry.gen() != (current_gen & 0x3F)) {
+            // Refresh generation, unless another thread rewrote the slot meanwhile
+            TTEntry refreshed = entry;
+            refreshed.set_gen(current_gen);
+            std::atomic_ref<uint64_t>(bucket.data[i])
+                .compare_exchange_strong(data, std::bit_cast<uint64_t>(refreshed), std::memory_order_relaxed);
         }
+        return true;
     }
     return false;
 }
 
 void TranspositionTable::prefetch(Key key) const {
-    size_t idx = key & (num_buckets - 1);
-    __builtin_prefetch(&buckets[idx]);
+    __builtin_prefetch(&bucket_of(key));
 }
 
 void TranspositionTable::store(Key key, uint16_t move, int score, int eval, int depth, int bound) {
-    size_t idx = key & (num_buckets - 1);
-    TTBucket& bucket = buckets[idx];
+    TTBucket& bucket = bucket_of(key);
+    TTEntry slots[TT_CLUSTER_SIZE];
+    for (int i = 0; i < TT_CLUSTER_SIZE; i++) slots[i] = std::bit_cast<TTEntry>(load_word(bucket.data[i]));
+
+    TTEntry entry;
+    entry.update(move, score, eval, depth, bound, current_gen);
+
+    // 1. Update the position's own entry: replace if deeper or from an older search
+    for (int i = 0; i < TT_CLUSTER_SIZE; i++) {
+        if (!slot_matches(bucket, i, key, std::bit_cast<uint64_t>(slots[i]))) continue;
+        const TTEntry& e = slots[i];
+        if (depth >= e.depth || e.gen() != (current_gen & 0x3F)) {
+            write_slot(bucket, i, key, entry);
+        }
+        return;
+    }
 
-    int replace_idx = -1;
+    // 2. Not found, choose victim: an empty slot, else the oldest and
+    // shallowest entry, sparing exact ones
+    int replace_idx = 0;
+    int best_score = -10000;
 
-    // 1. Check if key is already in bucket
-    for (int i = 0; i < 2; i++) {
-        if (bucket.entries[i].key == key) {
+    for (int i = 0; i < TT_CLUSTER_SIZE; i++) {
+        const TTEntry& e = slots[i];
+        if (e.bound() == 0) {
             replace_idx = i;
             break;
         }
+
+        int age = e.relative_age(current_gen & 0x3F);
+        int victim_score = age * 1000 - e.depth;
+        if (e.bound() == 1) victim_score -= 5000;
+
+        if (victim_score > best_score) {
+            best_score = victim_score;
+            replace_idx = i;
+        }
     }
 
-    if (replace_idx != -1) {
-        // Update existing
-        TTEntry& e = bucket.entries[replace_idx];
+    write_slot(bucket, replace_idx, key, entry);
+}
 
-        // Replace if deeper OR entry is from different generation
-        // Note: old logic was e.gen != current_gen.
-        // With modular aging, we might want "if older than current".
-        // But for exact replacement, strict "not equal" is usually fine to refresh.
-        // Or if we want to be strict about "better" entry:
-        // if (depth >= e.depth || (e.gen() != (current_gen & 0x3F)))
-        // Let's stick to the logic provided: replacement if deeper or older.
+int TranspositionTable::hashfull() const {
+    size_t sample = std::min<size_t>(num_buckets, 1000);
+    if (sample == 0) return 0;
+    int count = 0;
+    for (size_t i = 0; i < sample; i++) {
+        const TTBucket& bucket = buckets[i * num_buckets / sample];
+        for (int j = 0; j < TT_CLUSTER_SIZE; j++) {
+            // Search threads may be writing: same relaxed loads as probe()
+            TTEntry e = std::bit_cast<TTEntry>(load_word(bucket.data[j]));
+            if (e.bound() != 0 && e.gen() == (current_gen & 0x3F)) count++;
+        }
+    }
+    return (int)(count * 1000 / (sample * TT_CLUSTER_SIZE));
+}
 
-        bool replace = (depth >= e.depth || e.gen() != (current_gen & 0x3F));
+TTOccupancy TranspositionTable::occupancy(size_t sample_buckets) const {
+    TTOccupancy occ;
+    size_t sample = std::min(num_buckets, sample_buckets);
+    for (size_t i = 0; i < sample; i++) {
+        const TTBucket& bucket = buckets[i * num_buckets / sample];
+        for (int j = 0; j < TT_CLUSTER_SIZE; j++) {
+            TTEntry e = std::bit_cast<TTEntry>(load_word(bucket.data[j]));
+            occ.slots++;
+            if (e.bound() == 0) {
+                occ.empty++;
+                continue;
+            }
+            int age = std::min<int>(e.relative_age(current_gen & 0x3F), TTOccupancy::AGES - 1);
+            int depth = std::min<int>(e.depth / 4, TTOccupancy::DEPTHS - 1);
+            occ.count[age][depth]++;
+        }
+    }
+    return occ;
+}
 
-        e.key = key; // Redundant but safe
-        e.set_gen(current_gen);
+size_t TranspositionTable::suggested_size_mb(const TTOccupancy& occ) const {
+    if (occ.slots == 0) return 0;
+    uint64_t current = 0;
+    for (uint64_t c : occ.count[0]) current += c;
+    // Writes land in random clusters, so a search that wrote w slots into n
+    // fills about 1 - exp(-w/n) of them: estimate w from the fill, capped
+    // where the estimate stops meaning anything, and size for half full
+    double fill = std::min(0.99, (double)current / occ.slots);
+    double ratio = std::log(1.0 - fill) / std::log(0.5);
+    if (ratio < 2.0) return 0;
+    size_t mb = std::max<size_t>(size_mb(), 1);
+    size_t target = 1;
+    while (target < mb * ratio) target *= 2;
+    return target;
+}
 
-        if (replace) {
-             e.update(key, move, score, eval, depth, bound, current_gen);
+void print_occupancy(std::ostream& out, const TranspositionTable& tt) {
+    TTOccupancy occ = tt.occupancy();
+    if (occ.slots == 0) return;
+    auto permille = [&](uint64_t n) { return n * 1000 / occ.slots; };
+    out << "info string hash occupancy permille empty " << permille(occ.empty) << std::endl;
+    for (int age = 0; age < TTOccupancy::AGES; age++) {
+        out << "info string hash age " << age << (age == TTOccupancy::AGES - 1 ? "+" : "") << " depth";
+        for (int d = 0; d < TTOccupancy::DEPTHS; d++) {
+            out << " " << d * 4 << (d == TTOccupancy::DEPTHS - 1 ? "+" : "-" + std::to_string(d * 4 + 3))
+                << ":" << permille(occ.count[age][d]);
         }
-        return;
+        out << std::endl;
+    }
+    size_t suggested = tt.suggested_size_mb(occ);
+    if (suggested) {
+        uint64_t current = 0;
+        for (uint64_t c : occ.count[0]) current += c;
+        out << "info string hash suggest Hash " << suggested << " MB (this search filled "
+            << current * 100 / occ.slots << "% of " << tt.size_mb() << " MB)" << std::endl;
     }
+}
 
-    // 2. Not found, choose victim
-    int best_score = -10000;
+void TranspositionTable::merge_from(TranspositionTable& src, const std::vector<Key>& keys) {
+    for (Key key : keys) {
+        TTBucket& bucket = src.bucket_of(key);
+        for (int i = 0; i < TT_CLUSTER_SIZE; i++) {
+            if (!slot_matches(bucket, i, key, bucket.data[i])) continue;
+            TTEntry e = std::bit_cast<TTEntry>(bucket.data[i]);
+            store(key, e.move, e.score, e.eval, e.depth, e.bound());
+            bucket.key16[i] = 0;
+            bucket.data[i] = 0;
+        }
+    }
+}
 
-    for (int i = 0; i < 2; i++) {
-        const TTEntry& e = bucket.entries[i];
+bool TranspositionTable::save(const std::string& path, uint64_t tag, std::string& error) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot create " + path;
+        return false;
+    }
 
-        // Age calculation using modular arithmetic
-        int age = e.relative_age(current_gen & 0x3F);
+    char page[kFileDataOffset] = {};
+    TTFileHeader h = make_header(num_buckets, tag, current_gen);
+    std::memcpy(page, &h, sizeof(h));
+    out.write(page, sizeof(page));
 
-        // Scoring replacement suitability
-        // Higher score = better candidate to replace (victim)
-        int victim_score = age * 1000;
-        victim_score -= e.depth; // Deeper = keep (lower victim score)
+    const char* data = reinterpret_cast<const char*>(buckets);
+    size_t bytes = num_buckets * sizeof(TTBucket);
+    for (size_t done = 0; done < bytes && out; done += kFileChunk) {
+        out.write(data + done, (std::streamsize)std::min(kFileChunk, bytes - done));
+    }
+    out.flush();
+    if (!out) {
+        error = "write failed on " + path;
+        return false;
+    }
+    return true;
+}
 
-        // Penalty for replacing exact entry?
-        // "never replace EXACT with non-EXACT if depths are similar"
-        // EXACT is 1.
-        if (e.bound() == 1) victim_score -= 5000;
+bool TranspositionTable::load(const std::string& path, uint64_t tag, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
 
-        if (victim_score > best_score) {
-            best_score = victim_score;
-            replace_idx = i;
+    TTFileHeader h{};
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if (!in || !header_valid(h)) {
+        error = path + " is not a hash file of this format";
+        return false;
+    }
+    if (h.tag != tag) {
+        error = path + " was saved with a different evaluation";
+        return false;
+    }
+
+    // Everything about the size is checked before the current table goes
+    if (h.num_buckets == 0 || h.num_buckets > kMaxFileMb * 1024 * 1024 / sizeof(TTBucket)
+        || h.num_buckets * sizeof(TTBucket) % (1024 * 1024) != 0) {
+        error = path + " has an unsupported size";
+        return false;
+    }
+    size_t bytes = h.num_buckets * sizeof(TTBucket);
+    in.seekg(0, std::ios::end);
+    if (!in || (size_t)in.tellg() < kFileDataOffset + bytes) {
+        error = path + " is truncated";
+        return false;
+    }
+
+    // On failure the table goes back to its old size, empty
+    size_t old_mb = size_mb();
+    auto restore = [&] {
+        if (buckets && size_mb() == old_mb) clear();
+        else resize(old_mb);
+    };
+    if (h.num_buckets != num_buckets) {
+        try {
+            resize(bytes / (1024 * 1024));
+        } catch (const std::bad_alloc&) {
+            error = "cannot allocate " + std::to_string(bytes / (1024 * 1024)) + " MB for " + path;
+            restore();
+            return false;
         }
     }
 
-    // Replace at replace_idx
-    TTEntry& e = bucket.entries[replace_idx];
-    e.update(key, move, score, eval, depth, bound, current_gen);
+    in.seekg(kFileDataOffset);
+    char* data = reinterpret_cast<char*>(buckets);
+    for (size_t done = 0; done < bytes && in; done += kFileChunk) {
+        in.read(data + done, (std::streamsize)std::min(kFileChunk, bytes - done));
+    }
+    if (!in) {
+        error = "read error on " + path;
+        restore();
+        return false;
+    }
+
+    current_gen = h.generation;
+    if (map_base) static_cast<TTFileHeader*>(map_base)->generation = current_gen;
+    return true;
 }
 
-int TranspositionTable::hashfull() const {
-    int sample = (num_buckets < 1000) ? num_buckets : 1000;
-    if (sample == 0) return 0;
-    int count = 0;
-    for (int i=0; i<sample; i++) {
-        if (buckets[i].entries[0].key != 0) count++;
-        if (buckets[i].entries[1].key != 0) count++;
+void TranspositionTable::set_backing_file(const std::string& path, uint64_t tag) {
+    backing_path = path;
+    backing_tag = tag;
+}
+
+// Maps backing_path shared, creating or resizing it as needed; false leaves
+// the caller to fall back to anonymous memory
+bool TranspositionTable::map_file(size_t bytes) {
+#if defined(__linux__)
+    int fd = open(backing_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    size_t total = kFileDataOffset + bytes;
+    TTFileHeader h{};
+    struct stat st;
+    bool reuse = fstat(fd, &st) == 0 && (size_t)st.st_size == total
+        && pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && header_valid(h)
+        && h.num_buckets == num_buckets && h.tag == backing_tag;
+
+    void* mem = MAP_FAILED;
+    if (reuse || ftruncate(fd, (off_t)total) == 0) {
+        mem = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     }
-    return (count * 500) / sample;
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    map_base = mem;
+    map_bytes = total;
+    buckets = reinterpret_cast<TTBucket*>(static_cast<char*>(mem) + kFileDataOffset);
+    page_kind = Memory::Pages::Standard;
+    restored = reuse;
+    current_gen = reuse ? h.generation : 0;
+    TTFileHeader fresh = make_header(num_buckets, backing_tag, current_gen);
+    std::memcpy(mem, &fresh, sizeof(fresh));
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+void TranspositionTable::stress_test(int threads, int duration_ms) {
+    // 64 keys with distinct low 16 bits, all indexing the first few
+    // clusters, so a verified hit can only be the probed key and every slot
+    // is fought over
+    TranspositionTable tt(1);
+    std::vector<Key> keys(64);
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (size_t i = 0; i < keys.size(); i++) keys[i] = ((xorshift(seed) >> 12) & ~0xFFFFULL) | i;
+
+    // Data is a function of the key, so any hit can be checked
+    auto expected = [](Key key) {
+        TTEntry e;
+        e.update((uint16_t)(key >> 16), (int16_t)(key >> 32), (int16_t)(key >> 48), (key >> 20) & 0x7F,
+                 1 + (int)((key >> 27) % 3), 0);
+        return e;
+    };
+    auto same_data = [](const TTEntry& a, const TTEntry& b) {
+        return a.move == b.move && a.score == b.score && a.eval == b.eval && a.depth == b.depth
+            && a.bound() == b.bound();
+    };
+
+    // The key half each key's writes leave in a slot, to tell which write a
+    // raw key half came from
+    std::vector<std::pair<uint16_t, Key>> key_halves;
+    for (Key key : keys) {
+        key_halves.push_back({(uint16_t)((uint16_t)key ^ data_check(std::bit_cast<uint64_t>(expected(key)))), key});
+    }
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> probes{0}, hits{0}, torn{0}, rejected{0}, stores{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            uint64_t rng = 0x9E3779B97F4A7C15ULL * (t + 1);
+            uint64_t n_probes = 0, n_hits = 0, n_torn = 0, n_rejected = 0, n_stores = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                for (int k = 0; k < 4096; k++) {
+                    uint64_t r = xorshift(rng);
+                    Key key = keys[r % keys.size()];
+                    TTEntry want = expected(key);
+                    if (r & 0x100) {
+                        tt.store(key, want.move, want.score, want.eval, want.depth, want.bound());
+                        n_stores++;
+                        continue;
+                    }
+                    // Raw read of the cluster, in probe()'s order: a key half
+                    // from one write over data from another is a torn slot,
+                    // and the key check must reject it
+                    const TTBucket& bucket = tt.bucket_of(key);
+                    for (int i = 0; i < TT_CLUSTER_SIZE; i++) {
+                        uint64_t data = load_word(bucket.data[i]);
+                        uint16_t half = load_word(bucket.key16[i]);
+                        if (std::bit_cast<TTEntry>(data).bound() == 0) continue;
+                        for (const auto& [h, writer] : key_halves) {
+                            if (h != half || same_data(std::bit_cast<TTEntry>(data), expected(writer))) continue;
+                            if ((uint16_t)(half ^ data_check(data)) == (uint16_t)writer) n_torn++;
+                            else n_rejected++;
+                        }
+                    }
+                    TTEntry got;
+                    n_probes++;
+                    if (!tt.probe(key, got)) continue;
+                    n_hits++;
+                    if (!same_data(got, want)) n_torn++;
+                }
+            }
+            probes += n_probes;
+            hits += n_hits;
+            torn += n_torn;
+            rejected += n_rejected;
+            stores += n_stores;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    done = true;
+    for (auto& th : pool) th.join();
+
+    std::cout << "ttstress: " << threads << " threads " << duration_ms << " ms stores " << stores
+              << " probes " << probes << " hits " << hits << " torn " << torn
+              << " rejected " << rejected << std::endl;
 }
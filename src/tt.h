@@ -2,16 +2,20 @@
 #define TT_H
 
 #include "types.h"
+#include "memory.h"
 #include <vector>
 #include <cstdint>
+#include <string>
+#include <ostream>
 
+// One slot's data, as returned by probe(). Stored packed in a single 64-bit
+// word so threads read and write it in one access.
 struct TTEntry {
-    Key key;            // 8 bytes
     uint16_t move;      // 2 bytes
     int16_t score;      // 2 bytes
     int16_t eval;       // 2 bytes
     uint8_t depth;      // 1 byte
-    uint8_t gen_bound;  // 1 byte (6 bits gen, 2 bits bound)
+    uint8_t gen_bound;  // 1 byte (6 bits gen, 2 bits bound; bound 0 = empty slot)
 
     // Helpers
     // Gen is stored in the upper 6 bits? No, let's use the layout:
@@ -31,8 +35,7 @@ struct TTEntry {
         return gen_bound & 0x3;
     }
 
-    void update(Key k, uint16_t m, int s, int e, int d, int b, int g) {
-        key = k;
+    void update(uint16_t m, int s, int e, int d, int b, int g) {
         move = m;
         score = (int16_t)s;
         eval = (int16_t)e;
@@ -48,8 +51,27 @@ struct TTEntry {
     }
 };
 
-struct TTBucket {
-    TTEntry entries[2];
+constexpr int TT_CLUSTER_SIZE = 3;
+
+// Three 10-byte slots per 32-byte cluster, two clusters per cache line. Keys
+// and data are kept in separate arrays so every data word is 8-byte aligned.
+// Only the low 16 bits of the key are kept (the cluster index comes from the
+// high bits), xored with a hash of the slot's data: a reader that catches a
+// key from one write and data from another sees a mismatch, not a hit.
+struct alignas(32) TTBucket {
+    uint16_t key16[TT_CLUSTER_SIZE];
+    uint16_t padding;
+    uint64_t data[TT_CLUSTER_SIZE];
+};
+
+// Sampled slot counts by age (searches since the slot was last written or
+// hit, last bin 3+) and stored depth (bins of 4 plies, last bin 16+)
+struct TTOccupancy {
+    static constexpr int AGES = 4;
+    static constexpr int DEPTHS = 5;
+    uint64_t slots = 0;
+    uint64_t empty = 0;
+    uint64_t count[AGES][DEPTHS] = {};
 };
 
 class TranspositionTable {
@@ -57,31 +79,81 @@ public:
     TranspositionTable(size_t size_mb = 16);
     ~TranspositionTable();
     void resize(size_t size_mb);
-    void set_large_pages(bool enabled);
+    void set_clear_threads(int n) { clear_threads = n > 0 ? n : 1; }
+    // Zeroes the table on up to set_clear_threads() threads, bound like the
+    // search threads so first touch spreads the pages over the NUMA nodes
     void clear();
+    long long last_clear_ms() const { return clear_ms; }
+    int last_clear_thread_count() const { return clear_threads_used; }
     void new_search(); // Increment generation
 
     bool probe(Key key, TTEntry& entry); // Not const because we update gen/age
     void store(Key key, uint16_t move, int score, int eval, int depth, int bound);
     void prefetch(Key key) const;
 
+    // Permille of slots used by the current search, from 1000 clusters
+    // spread over the whole table
     int hashfull() const;
+    TTOccupancy occupancy(size_t sample_buckets = 65536) const;
+    // Smallest power-of-two size in MB that the current search would fill to
+    // about half, or 0 if this size is fine
+    size_t suggested_size_mb(const TTOccupancy& occ) const;
+    Memory::Pages pages() const { return page_kind; }
+    size_t size_mb() const { return num_buckets * sizeof(TTBucket) / (1024 * 1024); }
+
+    // Hash files: a header page (format, size, generation and the caller's
+    // tag for the evaluation the scores came from) followed by the raw
+    // clusters. load() resizes the table to the saved size.
+    bool save(const std::string& path, uint64_t tag, std::string& error) const;
+    bool load(const std::string& path, uint64_t tag, std::string& error);
+
+    // Backs the table with a shared mapping of a hash file from the next
+    // resize() on (empty path = anonymous memory). A file of the same size
+    // and tag keeps its contents, so the table survives restarts.
+    void set_backing_file(const std::string& path, uint64_t tag);
+    bool file_backed() const { return map_base != nullptr; }
+    bool restored_from_file() const { return restored; }
+
+    // Stores src's entries for keys here, in that order, and removes them from src
+    void merge_from(TranspositionTable& src, const std::vector<Key>& keys);
+
+    // Hammers a private table with probe/store from several threads. Reports
+    // torn slots the key check rejected, and any that got through (torn)
+    static void stress_test(int threads, int duration_ms);
 
 private:
+    // Multiply-shift: maps the high key bits onto [0, num_buckets), any count
+    TTBucket& bucket_of(Key key) const {
+        return buckets[(size_t)(((unsigned __int128)key * num_buckets) >> 64)];
+    }
+
+    // Slot i of the bucket holds key (data is that slot's word, already loaded)
+    static bool slot_matches(const TTBucket& bucket, int i, Key key, uint64_t data);
+    static void write_slot(TTBucket& bucket, int i, Key key, const TTEntry& entry);
+
     void release();
-    bool allocate_large_pages(size_t bytes);
-    void allocate_standard(size_t bucket_count);
+    bool map_file(size_t bytes);
 
-    std::vector<TTBucket> fallback_buckets;
     TTBucket* buckets = nullptr;
     size_t num_buckets;
-    bool use_large_pages = false;
-    bool using_large_pages = false;
+    Memory::Pages page_kind = Memory::Pages::Standard;
     uint8_t current_gen; // 0-255, but we only use 6 bits
+    int clear_threads = 1;
+    int clear_threads_used = 1;
+    long long clear_ms = 0;
+
+    std::string backing_path;
+    uint64_t backing_tag = 0;
+    void* map_base = nullptr; // File mapping: header page + clusters
+    size_t map_bytes = 0;
+    bool restored = false;
 };
 
 extern TranspositionTable TTable;
 
+// info string lines: occupancy by age and depth, then a Hash suggestion if any
+void print_occupancy(std::ostream& out, const TranspositionTable& tt);
+
 // Mate score normalization constants and helpers
 constexpr int MATE_TH = 30000;
 
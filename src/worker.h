@@ -3,48 +3,100 @@
 
 #include "position.h"
 #include "search.h"
+#include "numa.h"
+#include "stats.h"
+#include "tt.h"
+#include "eval/eval.h"
+#include <barrier>
+#include <memory>
 #include <vector>
 #include <atomic>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <cstdint>
 
 class MovePicker;
 
+// Nodes between publications of a worker's node count (and limit checks).
+// Close to a go nodes limit every thread switches to publishing and
+// checking at every node, so the stop lands within a few nodes of it.
+constexpr long long NODE_BATCH = 1024;
+
+// Cap on each thread's deterministic-mode TT overlay
+constexpr size_t EPOCH_TT_MAX_MB = 16;
+
+// Per-ply search frame. The worker keeps STACK_OFFSET sentinel frames below
+// ply 0 so lookbacks such as (ss - 4) need no bounds checks.
+struct SearchStack {
+    uint16_t move;             // Move made from this ply (0 = none or null move)
+    Piece moved_piece;
+    int static_eval;
+    int16_t (*cont_hist)[64];  // ContHistory row for (moved_piece, to); nullptr if no move
+    uint16_t excluded_move;    // Singular extension search exclusion
+    int reduction;             // LMR reduction applied to the move being searched
+    uint16_t killers[2];
+};
+
+constexpr int STACK_OFFSET = 4;
+
+// Entries per correction-history table (power of two)
+constexpr int CORR_HISTORY_SIZE = 16384;
+
 // Per-thread search state
 class SearchWorker {
 public:
     SearchWorker(int id, SearchContext& context);
     ~SearchWorker();
 
+    // Workers carry ~1.5 MB of history; keep them on (huge) pages of their
+    // own, first touched by the thread that owns them.
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+
     void start_search(const Position& root_pos, const SearchLimits& limits);
-    void wait_for_completion();
     void stop();
 
+    // Runs one search to completion on the calling thread
     void search_loop();
 
-    long long get_nodes() const { return node_count.load(std::memory_order_relaxed); }
+    // Published count; lags the thread-local counter by at most NODE_BATCH
+    long long get_nodes() const { return published_nodes.load(std::memory_order_relaxed); }
+    void publish_nodes() { published_nodes.store(nodes, std::memory_order_relaxed); }
     int get_id() const { return thread_id; }
+    long long get_start_latency_us() const { return start_latency_us; }
 
     // History Tables
     int History[2][6][64];
     int CaptureHistory[2][6][64][6];
-    int16_t ContHistory[2][6][64][6][64];
+    // [previous piece][previous to][piece][to]; pieces carry colour so the
+    // same table serves lookbacks of any distance
+    int16_t ContHistory[12][64][12][64];
     uint16_t CounterMove[2][4096];
-    int KillerMoves[MAX_PLY][2];
-    int static_evals[MAX_PLY]; // Zahak: Used for improving logic
+    // Static eval corrections learned from search results, in 1/CORR_HISTORY_GRAIN cp,
+    // [side to move][key], keyed by the pawn structure and by each side's pieces
+    int16_t PawnCorrHistory[2][CORR_HISTORY_SIZE];
+    int16_t NonPawnCorrHistory[2][COLOR_NB][CORR_HISTORY_SIZE];
+    SearchStack stack[MAX_PLY + STACK_OFFSET + 1]; // stack[STACK_OFFSET + ply]
+    uint16_t pv_table[MAX_PLY][MAX_PLY]; // Triangular PV, row = ply
+    int pv_len[MAX_PLY];                 // End index (exclusive) of each row
 
     void update_history(int side, int pt, int to, int bonus);
     void update_capture_history(int side, int pt, int to, int captured_pt, int bonus);
-    void update_continuation(int side, int prev_pt, int prev_to, int pt, int to, int bonus);
+    int quiet_history(const SearchStack* ss, int side, Piece pc, int to) const;
+    void update_continuation(const SearchStack* ss, Piece pc, int to, int bonus);
     void update_counter_move(int side, int prev_from, int prev_to, uint16_t move);
+    void update_cutoff_histories(SearchStack* ss, const Position& pos, uint16_t best, bool best_quiet, int depth,
+                                 const uint16_t* quiets, int quiet_count, const uint16_t* captures, int capture_count);
+    void update_pv(int ply, uint16_t move);
+    int corrected_eval(const Position& pos, int raw_eval) const;
+    void update_correction_history(const Position& pos, int depth, int diff);
 
     friend class MovePicker;
     friend class Search;
+    friend class ThreadPool;
 
     // Search Functions
     int quiescence(SearchContext& context, Position& pos, int alpha, int beta, int ply);
-    int negamax(SearchContext& context, Position& pos, int depth, int alpha, int beta, int ply, bool null_allowed, uint16_t prev_move = 0, uint16_t excluded_move = 0);
+    int negamax(SearchContext& context, Position& pos, int depth, int alpha, int beta, int ply, bool null_allowed);
 
     // Root & Iterative Deepening
     void search_root(int depth, int alpha, int beta, std::vector<uint16_t>& root_moves, std::vector<int>& root_scores);
@@ -55,22 +107,66 @@ public:
 private:
     int thread_id;
     SearchContext* context;
-    std::atomic<long long> node_count;
+    // Nodes are counted in a plain per-thread integer and published in
+    // batches; the published copy sits on its own cache line so readers
+    // summing the pool never bounce the line the search is writing.
+    alignas(64) std::atomic<long long> published_nodes;
+    char published_pad[64 - sizeof(std::atomic<long long>)];
+    alignas(64) long long nodes;
+    long long node_check_mask = NODE_BATCH - 1; // Publish/check when (nodes & mask) == 0
     uint16_t best_move;
     int best_score;
     int depth_reached;
-    int pv_length;
+    std::vector<uint16_t> pv; // Best line of the last completed iteration
+    bool tb_root;
     std::vector<SearchResult::RootScore> root_scores;
 
-    std::thread worker_thread;
-    std::mutex mutex;
-    std::condition_variable cv;
-    bool exit_thread;
-    std::atomic<bool> searching;
+    long long start_latency_us; // Search start to this worker's first node, after per-search setup
+    Stats::Counters stats;      // Only incremented in STATS builds
 
     Position root_pos;
     SearchLimits limits;
 
+    // Deterministic mode (set by the pool when SearchLimits::deterministic runs
+    // with helpers): the thread stops on its own node budget rather than the
+    // pool total, and its TT writes go to epoch_tt, which the pool folds into
+    // the shared table in thread order between iterations.
+    long long node_budget = 0; // 0 = no per-thread budget
+    bool out_of_nodes = false;
+    bool epochs = false;
+    std::unique_ptr<TranspositionTable> epoch_tt;
+    std::vector<Key> epoch_keys; // Stored this epoch, in order; may repeat
+
+    bool stopped(const SearchContext& c) const { return out_of_nodes || c.stop_flag.load(std::memory_order_relaxed); }
+    bool tt_probe(Key key, TTEntry& tte) {
+        if (epochs && epoch_tt->probe(key, tte)) return true;
+        return TTable.probe(key, tte);
+    }
+    void tt_store(Key key, uint16_t move, int score, int eval, int depth, int bound) {
+        if (!epochs) return TTable.store(key, move, score, eval, depth, bound);
+        epoch_tt->store(key, move, score, eval, depth, bound);
+        epoch_keys.push_back(key);
+    }
+
+    // Installed for this thread's evals while searching
+    Eval::PawnTable pawn_table;
+    Eval::MaterialTable material_table;
+
+    // Quiescence-only table (QsTTPolicy::Local and Split)
+    std::unique_ptr<TranspositionTable> qs_tt;
+    bool qs_probe(Key key, TTEntry& tte) {
+        if (qs_tt && qs_tt->probe(key, tte)) return true;
+        return tt_probe(key, tte);
+    }
+    void qs_store(Key key, uint16_t move, int score, int eval, int bound, bool stand_pat) {
+        if (limits.qs_tt == QsTTPolicy::Local || (limits.qs_tt == QsTTPolicy::Split && stand_pat)) {
+            return qs_tt->store(key, move, score, eval, 0, bound);
+        }
+        tt_store(key, move, score, eval, 0, bound);
+    }
+
+    SearchStack* frame(int ply) { return &stack[STACK_OFFSET + ply]; }
+    void reset_stack();
     void check_limits(SearchContext& context);
     void decay_history();
 };
@@ -81,14 +177,43 @@ public:
     void start_search(const Position& pos, const SearchLimits& limits);
     void wait_for_completion();
     long long get_total_nodes() const;
+    long long max_start_latency_us() const;
+    Stats::Counters total_stats() const;
+    void reset_stats();
+    SearchWorker* best_thread() const;
+    bool deterministic() const { return epoch_barrier != nullptr; }
+    // Deterministic mode: every thread calls epoch_sync() before each new
+    // iteration and epoch_leave() once done; the last arrival merges all
+    // epoch tables, so TT contents only change between iterations
+    void epoch_sync() { epoch_barrier->arrive_and_wait(); }
+    void epoch_leave() { epoch_barrier->arrive_and_drop(); }
+    void merge_epoch();
     void set_context(SearchContext* ctx) { context = ctx; }
 
     std::vector<SearchWorker*> workers;
     SearchWorker* master;
     SearchContext* context;
+    Numa::Binding binding;
 
-    ThreadPool() : master(nullptr), context(nullptr) {}
+    ThreadPool() : master(nullptr), context(nullptr), binding(Numa::Binding::None) {}
     ~ThreadPool();
+
+private:
+    void release();
+    void idle_loop(SearchWorker* worker, uint64_t seen);
+
+    std::vector<std::thread> threads; // One per helper; runs idle_loop
+
+    struct EpochMerge {
+        ThreadPool* pool;
+        void operator()() noexcept { pool->merge_epoch(); }
+    };
+    std::unique_ptr<std::barrier<EpochMerge>> epoch_barrier;
+
+    // Helpers wait for this to change; one release store starts a search
+    std::atomic<uint64_t> generation{0};
+    std::atomic<int> active{0};
+    std::atomic<bool> exiting{false};
 };
 
 #endif // WORKER_H